@@ -1,7 +1,8 @@
 import os
 import json
 import argparse
-from script_maker import create_jobs
+from script_maker import create_jobs, OUTPUT_ROOT
+from manifest import Manifest, build_id
 
 def load_sample(era):
     list_path = f"./list/{era}.list"
@@ -12,6 +13,10 @@ def load_sample(era):
         samples = [line.strip() for line in f if line.strip()]
     return samples
 
+def load_config(era):
+    with open(f"./../input/config/{era}/config.json") as f:
+        return json.load(f)
+
 def update_config(era, nfiles):
     config_path = f"./../input/config/{era}/config.json"
     
@@ -39,19 +44,29 @@ def main():
                       help='Number of files per job (default: 10)')
     parser.add_argument('--eras', nargs='+', default=["2016_postVFP"],
                       help='Eras to process (default: 2016_postVFP)')
+    parser.add_argument('--force', action='store_true',
+                      help='Resubmit every job, ignoring the manifest')
     
     args = parser.parse_args()
     
     print(f"[INFO] Will process {args.nfiles} files per job")
+    build = build_id("./../build/libAnalysisLib.so")
     
     for era in args.eras:
         if not update_config(era, args.nfiles):
             continue
         
+        config = load_config(era)
+        manifest = Manifest(f"{OUTPUT_ROOT}/{era}")
+        if args.force:
+            manifest.data["jobs"] = {}
+
         samples = load_sample(era)
         for sample in samples:
             list_dir = f"./../input/{era}/{sample}"
-            create_jobs(era=era, sample=sample, list_dir=list_dir, files_per_job=args.nfiles)
+            create_jobs(era=era, sample=sample, list_dir=list_dir, files_per_job=args.nfiles,
+                        manifest=manifest, config=config, build=build)
+            manifest.save()
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,157 @@
+import os
+import sys
+import json
+import time
+import hashlib
+
+# One manifest per era output directory, e.g. output/250526/2018/manifest.json
+#   jobs   : "<sample>_<idx>" -> hash of (input files, config subtree, library build) + submit time
+#   merged : "<sample>" -> hash over the job hashes and job output states that went into combined/<sample>.root
+MANIFEST_NAME = "manifest.json"
+
+# Output base shared by the submit side (condor_sub.py) and the merge side (hadd.sh)
+OUTPUT_ROOT = "/u/user/haeun/CMSAnalysis/HighBoostedZ/HighPt/HighBoostedZ/output/250526"
+# The jobs run from build/, so relative paths in the config resolve against it
+BUILD_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "build")
+
+
+def sha256(data):
+    return hashlib.sha256(data).hexdigest()
+
+
+# Every job of a sample hashes the same files, so each is read once per version
+_file_hashes = {}
+
+
+def file_sha256(path):
+    stat = os.stat(path)
+    key = (os.path.abspath(path), stat.st_size, stat.st_mtime_ns)
+    if key not in _file_hashes:
+        h = hashlib.sha256()
+        with open(path, "rb") as f:
+            for chunk in iter(lambda: f.read(1 << 20), b""):
+                h.update(chunk)
+        _file_hashes[key] = h.hexdigest()
+    return _file_hashes[key]
+
+
+def build_id(lib_path):
+    if not os.path.exists(lib_path):
+        print(f"[WARNING] Analysis library not found: {lib_path}")
+        return ""
+    return file_sha256(lib_path)
+
+
+def config_subtree(config, sample, build_dir=BUILD_DIR):
+    # Only what this sample's job reads: its own trigger list and IsMC flag, and for MC
+    # the scale-factor tables together with the contents of their ROOT files
+    subtree = {k: v for k, v in config.items() if k not in ("IsMC", "ScaleFactor")}
+    is_mc = config.get("IsMC", {}).get(sample, True)
+    subtree["IsMC"] = is_mc
+
+    muon = dict(config.get("Muon", {}))
+    trigger = muon.pop("Trigger", {})
+    muon["Trigger"] = trigger.get("Exception", {}).get(sample, trigger.get("Default"))
+    subtree["Muon"] = muon
+
+    if is_mc and "ScaleFactor" in config:
+        tables = {}
+        for name, sf in config["ScaleFactor"].items():
+            path = os.path.join(build_dir, sf["File"])
+            tables[name] = dict(sf, sha256=file_sha256(path) if os.path.exists(path) else "")
+        subtree["ScaleFactor"] = tables
+    return subtree
+
+
+def job_hash(files, config, sample, build):
+    payload = json.dumps({"files": files, "config": config_subtree(config, sample), "build": build}, sort_keys=True)
+    return sha256(payload.encode())
+
+
+class Manifest:
+    def __init__(self, era_dir):
+        self.path = os.path.join(era_dir, MANIFEST_NAME)
+        self.data = {"jobs": {}, "merged": {}}
+        if os.path.exists(self.path):
+            with open(self.path) as f:
+                self.data = json.load(f)
+
+    def save(self):
+        os.makedirs(os.path.dirname(self.path), exist_ok=True)
+        tmp_path = self.path + ".tmp"
+        with open(tmp_path, "w") as f:
+            json.dump(self.data, f, indent=2, sort_keys=True)
+        os.replace(tmp_path, self.path)
+
+    def up_to_date(self, key, new_hash, output):
+        # The output must also be newer than the submission that recorded the hash
+        entry = self.data["jobs"].get(key)
+        if not entry or entry["hash"] != new_hash or not os.path.exists(output):
+            return False
+        return os.path.getmtime(output) >= entry["submitted"]
+
+    def record(self, key, new_hash, output):
+        self.data["jobs"][key] = {"hash": new_hash, "output": output, "submitted": time.time()}
+
+    def drop_stale(self, sample, keys):
+        # Jobs of this sample that no longer exist, e.g. after FilesPerJob changed
+        stale = [k for k, v in self.data["jobs"].items() if k.rsplit("_", 1)[0] == sample and k not in keys]
+        for key in stale:
+            output = self.data["jobs"].pop(key)["output"]
+            if os.path.exists(output):
+                print(f"[INFO] Removing stale output {output}")
+                os.remove(output)
+
+    def group_hash(self, sample):
+        # A resubmitted job keeps its hash, so its output's size and mtime are what show that
+        # it failed before and has an output to merge now
+        states = []
+        for key, job in sorted(self.data["jobs"].items()):
+            if key.rsplit("_", 1)[0] != sample:
+                continue
+            output = job["output"]
+            if os.path.exists(output):
+                stat = os.stat(output)
+                states.append(f"{job['hash']}:{stat.st_size}:{stat.st_mtime_ns}")
+            else:
+                states.append(f"{job['hash']}:missing")
+        return sha256(";".join(states).encode()) if states else ""
+
+    def needs_merge(self, sample, merged_output):
+        current = self.group_hash(sample)
+        if not current or not os.path.exists(merged_output):
+            return True
+        return self.data["merged"].get(sample) != current
+
+    def mark_merged(self, sample):
+        self.data["merged"][sample] = self.group_hash(sample)
+
+
+def main():
+    # Used by hadd.sh:
+    #   manifest.py output-root
+    #   manifest.py needs-merge <era_dir> <sample> <merged_output>  (exit 0: merge needed)
+    #   manifest.py mark-merged <era_dir> <sample>
+    if len(sys.argv) == 2 and sys.argv[1] == "output-root":
+        print(OUTPUT_ROOT)
+        return
+
+    if len(sys.argv) < 4:
+        print("Usage: manifest.py output-root | needs-merge|mark-merged <era_dir> <sample> [merged_output]")
+        sys.exit(2)
+
+    command, era_dir, sample = sys.argv[1:4]
+    manifest = Manifest(era_dir)
+
+    if command == "needs-merge":
+        sys.exit(0 if manifest.needs_merge(sample, sys.argv[4]) else 1)
+    elif command == "mark-merged":
+        manifest.mark_merged(sample)
+        manifest.save()
+    else:
+        print(f"[ERROR] Unknown command: {command}")
+        sys.exit(2)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,28 @@
+#!/bin/bash
+# Runs one era through the Coordinator with N local Analyzer workers.
+# Usage (from build/): ../Batch/run_local.sh <era> [nWorkers]
+
+ERA=${1:-2016_postVFP}
+NWORKERS=${2:-$(nproc)}
+SOCKET="/tmp/hbz_${ERA}_$$.sock"
+
+./Coordinator "$ERA" "$SOCKET" &
+COORD_PID=$!
+
+while [ ! -S "$SOCKET" ]; do
+  if ! kill -0 $COORD_PID 2>/dev/null; then
+    echo "Coordinator exited before listening"
+    exit 1
+  fi
+  sleep 0.2
+done
+
+mkdir -p "../output/250526/$ERA/Log"
+for i in $(seq 1 "$NWORKERS"); do
+  ./Analyzer --worker "$SOCKET" > "../output/250526/$ERA/Log/worker_$i.log" 2>&1 &
+done
+
+wait $COORD_PID
+STATUS=$?
+wait
+exit $STATUS
@@ -1,4 +1,5 @@
 import os
+from manifest import job_hash, OUTPUT_ROOT
 
 def parse_list(list_dir):
     input_files = []
@@ -13,23 +14,35 @@ def split_list(lst, split_size):
     for i in range(0, len(lst), split_size):
         yield lst[i:i + split_size]
 
-def create_jobs(era, sample, list_dir, files_per_job):
+def create_jobs(era, sample, list_dir, files_per_job, manifest=None, config=None, build=""):
     base_dir = os.getcwd()
-    output_base = f"/u/user/haeun/CMSAnalysis/HighBoostedZ/HighPt/HighBoostedZ/output/250526/{era}/{sample}"
+    output_base = f"{OUTPUT_ROOT}/{era}/{sample}"
     submit_dir = os.path.join(output_base, "Sub")
     log_dir = os.path.join(output_base, "Log")
 
     os.makedirs(submit_dir, exist_ok=True)
     os.makedirs(log_dir, exist_ok=True)
 
-    input_files = parse_list(list_dir)
+    # Sorted like NtupleReader, so split idx is exactly the slice job idx reads
+    input_files = sorted(parse_list(list_dir))
     print(f"[INFO] Found {len(input_files)} input files for sample '{sample}'.")
 
     job_splits = list(split_list(input_files, files_per_job))
+    if manifest is not None:
+        manifest.drop_stale(sample, {f"{sample}_{idx}" for idx in range(len(job_splits))})
 
+    n_skipped = 0
     for idx, split in enumerate(job_splits):
         jobname = f"{sample}_{idx}"
 
+        if manifest is not None:
+            output = f"{output_base}/{jobname}.root"
+            new_hash = job_hash(split, config, sample, build)
+            if manifest.up_to_date(jobname, new_hash, output):
+                n_skipped += 1
+                continue
+            manifest.record(jobname, new_hash, output)
+
         list_path = os.path.join(submit_dir, f"{jobname}.list")
         with open(list_path, "w") as f_list:
             for filepath in split:
@@ -56,4 +69,7 @@ def create_jobs(era, sample, list_dir, files_per_job):
             sub.write(f"transfer_input_files = ../input/config/{era}/config.json\n")
             sub.write("queue 1\n")
 
-        os.system(f"condor_submit {sub_path}")
\ No newline at end of file
+        os.system(f"condor_submit {sub_path}")
+
+    if n_skipped:
+        print(f"[INFO] Skipped {n_skipped}/{len(job_splits)} up-to-date jobs for sample '{sample}'.")
\ No newline at end of file
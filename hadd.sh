@@ -1,8 +1,14 @@
 #!/bin/bash
+shopt -s extglob
 
-BASE_DIR="./output/250517"
+MANIFEST="python3 ./Batch/manifest.py"
+# Same output base the jobs and their manifest were submitted with
+BASE_DIR=$($MANIFEST output-root) || exit 1
 ERAS=("2016_postVFP" "2016_preVFP" "2017" "2018")
 
+# Samples re-merged in this run, per era; final groups are only redone if one of them changed
+declare -A REMERGED
+
 for era in "${ERAS[@]}"; do
   echo -e "\n========================= Processing era: $era ========================="
   
@@ -12,6 +18,10 @@ for era in "${ERAS[@]}"; do
     fi
     
     sample=$(basename "$sample_dir")
+    # Final group outputs of a previous run, not a sample
+    if [ "$sample" == "combined" ]; then
+      continue
+    fi
     echo -e "\n========================= Processing sample: $sample =========================\n"
     
     combined_dir="$sample_dir/combined"
@@ -31,12 +41,30 @@ for era in "${ERAS[@]}"; do
       continue
     fi
     
+    if ! $MANIFEST needs-merge "$BASE_DIR/$era" "$sample" "$combined_dir/${pattern}.root"; then
+      echo -e "    Up to date, skipping.\n"
+      continue
+    fi
+
     hadd_command="hadd -f $combined_dir/${pattern}.root $sample_dir/${pattern}_*.root"
     echo "    $hadd_command"
-    eval "$hadd_command"
+    if eval "$hadd_command"; then
+      $MANIFEST mark-merged "$BASE_DIR/$era" "$sample"
+      REMERGED[$era]="${REMERGED[$era]} $sample "
+    fi
   done
 done
 
+# Final group needs a merge if its output is missing or any member sample was re-merged
+group_changed() {
+  local era=$1 output=$2 pattern=$3
+  [ ! -f "$output" ] && return 0
+  for sample in ${REMERGED[$era]}; do
+    [[ "$sample" == $pattern ]] && return 0
+  done
+  return 1
+}
+
 # Final combination
 for era in "${ERAS[@]}"; do
   echo -e "\n========================= Processing final combination for era: $era =========================\n"
@@ -87,49 +115,49 @@ for era in "${ERAS[@]}"; do
   final_dir="$BASE_DIR/$era/combined"
   mkdir -p "$final_dir"
   
-  if [ ! -z "$dy_files" ]; then
+  if [ ! -z "$dy_files" ] && group_changed "$era" "$final_dir/DY_$era.root" "DYJetsToMuMu*"; then
     hadd_command="hadd -f $final_dir/DY_$era.root $dy_files"
     echo -e "========================= DY =========================\n"
     echo "$hadd_command"
     eval "$hadd_command"
   fi
   
-  if [ ! -z "$st_files" ]; then
+  if [ ! -z "$st_files" ] && group_changed "$era" "$final_dir/ST_$era.root" "ST_*"; then
     hadd_command="hadd -f $final_dir/ST_$era.root $st_files"
     echo -e "\n========================= ST =========================\n"
     echo "$hadd_command"
     eval "$hadd_command"
   fi
   
-  if [ ! -z "$tt_files" ]; then
+  if [ ! -z "$tt_files" ] && group_changed "$era" "$final_dir/TT_$era.root" "TT*"; then
     hadd_command="hadd -f $final_dir/TT_$era.root $tt_files"
     echo -e "\n========================= TT =========================\n"
     echo "$hadd_command"
     eval "$hadd_command"
   fi
   
-  if [ ! -z "$ew_files" ]; then
+  if [ ! -z "$ew_files" ] && group_changed "$era" "$final_dir/EW_$era.root" "@(WW*|WZ|ZZ)"; then
     hadd_command="hadd -f $final_dir/EW_$era.root $ew_files"
     echo -e "\n========================= EW =========================\n"
     echo "$hadd_command"
     eval "$hadd_command"
   fi
 
-  if [ ! -z "$wjets_files" ]; then
+  if [ ! -z "$wjets_files" ] && group_changed "$era" "$final_dir/WJets_$era.root" "WJets*"; then
     hadd_command="hadd -f $final_dir/WJets_$era.root $wjets_files"
     echo -e "\n======================= WJets =========================\n"
     echo "$hadd_command"
     eval "$hadd_command"
   fi
 
-  if [ ! -z "$dytau_files" ]; then
+  if [ ! -z "$dytau_files" ] && group_changed "$era" "$final_dir/DY_TauTau_$era.root" "DYJetsToTauTau*"; then
     hadd_command="hadd -f $final_dir/DY_TauTau_$era.root $dytau_files"
     echo -e "\n===================== DY_TauTau ======================\n"
     echo "$hadd_command"
     eval "$hadd_command"
   fi
   
-  if [ ! -z "$data_files" ]; then
+  if [ ! -z "$data_files" ] && group_changed "$era" "$final_dir/Data_$era.root" "*Run*"; then
     hadd_command="hadd -f $final_dir/Data_$era.root $data_files"
     echo -e "\n======================= Data =========================\n"
     echo "$hadd_command"
@@ -0,0 +1,33 @@
+#ifndef AllocTracker_h
+#define AllocTracker_h 1
+
+#include <cstddef>
+
+
+// Counts operator new calls per event-loop stage.
+// Only active when built with -DALLOC_TRACKING=ON (HBZ_ALLOC_TRACKING); otherwise every call is a no-op.
+class AllocTracker
+{
+public:
+  enum Stage { kOther, kRead, kGen, kMuon, kTrigger, kSelection, kDimuon, kNStages };
+
+  // Processed events before counting starts, so reserve()/first-fill growth is not reported
+  static constexpr long long kWarmupEvents = 1000;
+
+#ifdef HBZ_ALLOC_TRACKING
+  static void SetStage(Stage stage);
+  // Called once per processed (loaded) event; counting starts after kWarmupEvents of them
+  static void CountEvent();
+  // Prints allocations and bytes per event for each stage.
+  // False if any stage except kRead allocated; a job too short to be checked passes.
+  // kRead is reported but not checked: ROOT allocates there when it opens a file or reads
+  // a new basket, which the analysis code cannot avoid.
+  static bool Report();
+#else
+  static void SetStage(Stage) {}
+  static void CountEvent() {}
+  static bool Report() { return true; }
+#endif
+};
+
+#endif
@@ -3,10 +3,15 @@
 
 #include "NtupleReader.h"
 #include "Muon.h"
+#include "ScaleFactor.h"
+#include "GenParticle.h"
+#include "Bootstrap.h"
+#include "EventArena.h"
 
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 #include "TH1.h"
 #include "TH2.h"
 
@@ -22,15 +27,23 @@ public:
     delete fMuon;
   }
 
-  bool Init(const std::string& sampleName, const std::string& era, const int& idx);
-  void Run();
+  bool Init(const std::string& sampleName, const std::string& era, const int& idx, const std::string& outputName = "");
+  void Run(long long firstEntry = 0, long long nEntries = -1);
   void End();
   bool IsMC() { return fIsMC; }
+  // False only in ALLOC_TRACKING builds when the steady-state event loop allocated;
+  // jobs too short to be checked count as allocation-free
+  bool IsAllocationFree() { return fAllocationFree; }
 
 private:
   std::unique_ptr<NtupleReader> fNtupleReader;
+  std::unique_ptr<GenParticle> fGenParticle;
   TTreeReader* fReader;
   Muon* fMuon;
+  ScaleFactor fScaleFactor;
+  Bootstrap fBootstrap;
+  std::unordered_map<const TH1*, int> fReplicaSlots;   // bootstrap slot of each histogram with replicas
+  EventArena fArena;
 
   std::string fSampleName;
   std::string fEra;
@@ -38,6 +51,7 @@ private:
   int fIdx;
   Selection fMuonConfig;
   bool fIsMC;
+  bool fAllocationFree = true;
 
   TH1F* h_TotalWeight;
   
@@ -90,9 +104,30 @@ private:
   TH1F* h_DimuonRapidity_MassCut;
   TH1F* h_DimuonPhi_MassCut;
   TH1F* h_DimuonMass_MassCut;
+
+  TH1F* h_DimuonMass_SFUp;
+  TH1F* h_DimuonMass_SFDown;
+  TH1F* h_DimuonMass_MassCut_SFUp;
+  TH1F* h_DimuonMass_MassCut_SFDown;
+
+  TH1F* h_GenDimuonMass;
+  TH1F* h_GenDimuonMass_Matched;
+  TH1F* h_DimuonMass_Resolution;
+  TH2F* h_DimuonMass_Response;
   
   void SetHist();
   void FillHist();
+  // Every histogram is created through Book, which gives it bootstrap replicas unless it is excluded
+  template <typename T>
+  T* Book(T* hist) {
+    int slot = fBootstrap.Register(hist);
+    if (slot >= 0) fReplicaSlots[hist] = slot;
+    return hist;
+  }
+  int ReplicaSlot(const TH1* hist) const;
+  // Fills the histogram and, in bootstrap mode, its replicas
+  void Fill(TH1* hist, double x, double w);
+  void Fill(TH2* hist, double x, double y, double w);
   void WriteHist();
 };
 
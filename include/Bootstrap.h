@@ -0,0 +1,67 @@
+#ifndef Bootstrap_h
+#define Bootstrap_h 1
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include "TH1.h"
+#include "TTreeReader.h"
+#include "TTreeReaderValue.h"
+#include "Muon.h"
+
+
+// Poisson(1) bootstrap replicas of the booked histograms, made in the same pass.
+// Replica weights depend only on (run, lumi, event, replica), not on the job splitting or threading.
+class Bootstrap
+{
+public:
+  Bootstrap() : fNReplicas(0) {}
+  ~Bootstrap() {}
+
+  bool Init(const Selection& config, TTreeReader* fReader);
+  bool IsActive() const { return fNReplicas > 0; }
+
+  // Slot for the replicas of hist, -1 if it is excluded.
+  // Every histogram gets replicas except those named in "Bootstrap":{"Exclude":[...]}.
+  int Register(TH1* hist);
+  // Reads run, lumi and event of the current entry
+  void Load();
+  // Draws this event's replica weights
+  void SetEvent();
+  void Fill(int slot, double x, double w);
+  void Fill(int slot, double x, double y, double w);
+  // Writes <name>_bootstrap to the current directory: a THnSparseF over the histogram's axes
+  // plus a replica axis, holding only the filled bins
+  void Write();
+
+private:
+  // A row holds the fNReplicas contents of one filled cell. Register maps address space for
+  // a row per cell, so the loop never allocates; rows are handed out in the order cells are
+  // first filled, so only the pages of used rows are ever backed by memory
+  struct Unmap {
+    size_t bytes;
+    void operator()(float* rows) const;
+  };
+  struct Slot {
+    TH1* hist;
+    std::vector<int> rowOfCell;           // -1 until the cell is filled
+    std::unique_ptr<float, Unmap> rows;   // zero-filled by the kernel on first touch
+    int nRows = 0;
+  };
+
+  int fNReplicas;
+  std::vector<std::string> fExcluded;
+  std::vector<uint32_t> fThresholds;   // Poisson(1) CDF scaled to 2^32
+  std::vector<float> fWeights;         // this event's Poisson counts
+  std::vector<Slot> fSlots;
+
+  std::unique_ptr<TTreeReaderValue<UInt_t>> run;
+  std::unique_ptr<TTreeReaderValue<UInt_t>> luminosityBlock;
+  std::unique_ptr<TTreeReaderValue<ULong64_t>> event;
+
+  float* Row(Slot& slot, int cell);
+  void FillCell(Slot& slot, int cell, double w);
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef Collection_h
+#define Collection_h 1
+
+#include <array>
+#include <tuple>
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <algorithm>
+#include <type_traits>
+#include "TTreeReader.h"
+#include "TTreeReaderArray.h"
+
+
+// NanoAOD column tags: element type and branch suffix (<prefix>_<name>)
+namespace Col {
+  struct pt { typedef float type; static constexpr const char* name = "pt"; };
+  struct eta { typedef float type; static constexpr const char* name = "eta"; };
+  struct phi { typedef float type; static constexpr const char* name = "phi"; };
+  struct mass { typedef float type; static constexpr const char* name = "mass"; };
+  struct charge { typedef int type; static constexpr const char* name = "charge"; };
+
+  struct tunepRelPt { typedef float type; static constexpr const char* name = "tunepRelPt"; };
+  struct highPtId { typedef unsigned char type; static constexpr const char* name = "highPtId"; };
+  struct tkRelIso { typedef float type; static constexpr const char* name = "tkRelIso"; };
+  struct nTrackerLayers { typedef int type; static constexpr const char* name = "nTrackerLayers"; };
+
+  struct cutBased { typedef int type; static constexpr const char* name = "cutBased"; };
+  struct pfRelIso03_all { typedef float type; static constexpr const char* name = "pfRelIso03_all"; };
+
+  struct jetId { typedef int type; static constexpr const char* name = "jetId"; };
+  struct btagDeepFlavB { typedef float type; static constexpr const char* name = "btagDeepFlavB"; };
+
+  struct pdgId { typedef int type; static constexpr const char* name = "pdgId"; };
+  struct statusFlags { typedef int type; static constexpr const char* name = "statusFlags"; };
+}
+
+// Objects per event a Mask or IndexList can hold
+constexpr size_t kMaxObjects = 256;
+
+// Selection mask over the objects of one event, kept on the stack
+class Mask
+{
+public:
+  explicit Mask(size_t size = 0) : fSize(std::min(size, kMaxObjects)) { fBits.fill(0); }
+
+  size_t Size() const { return fSize; }
+  void Set(size_t i) { fBits[i / 64] |= (uint64_t(1) << (i % 64)); }
+  bool Test(size_t i) const { return fBits[i / 64] & (uint64_t(1) << (i % 64)); }
+  size_t Count() const {
+    size_t n = 0;
+    for (auto word : fBits) n += __builtin_popcountll(word);
+    return n;
+  }
+  Mask operator&(const Mask& other) const {
+    Mask mask(std::min(fSize, other.fSize));
+    for (size_t w = 0; w < fBits.size(); w++) mask.fBits[w] = fBits[w] & other.fBits[w];
+    return mask;
+  }
+
+private:
+  std::array<uint64_t, kMaxObjects / 64> fBits;
+  size_t fSize;
+};
+
+// Fixed-capacity list of object indices (candidates)
+class IndexList
+{
+public:
+  IndexList() : fSize(0) {}
+
+  void Push(int idx) { if (fSize < kMaxObjects) fIdx[fSize++] = idx; }
+  size_t Size() const { return fSize; }
+  int operator[](size_t i) const { return fIdx[i]; }
+  const int* begin() const { return fIdx.data(); }
+  const int* end() const { return fIdx.data() + fSize; }
+  int* begin() { return fIdx.data(); }
+  int* end() { return fIdx.data() + fSize; }
+
+private:
+  std::array<int, kMaxObjects> fIdx;
+  size_t fSize;
+};
+
+template <typename T, typename... Ts>
+struct ColumnIndex;
+
+template <typename T, typename... Ts>
+struct ColumnIndex<T, T, Ts...> : std::integral_constant<size_t, 0> {};
+
+template <typename T, typename U, typename... Ts>
+struct ColumnIndex<T, U, Ts...> : std::integral_constant<size_t, 1 + ColumnIndex<T, Ts...>::value> {};
+
+// Structure-of-arrays view of one NanoAOD collection whose columns are fixed at compile time.
+// The readers live inside the collection (no per-column heap objects) and read straight
+// from the branch buffers. The first column gives the collection size.
+template <typename... Cols>
+class Collection
+{
+public:
+  explicit Collection(const std::string& prefix) : fPrefix(prefix) {}
+  Collection(const Collection&) = delete;
+  Collection& operator=(const Collection&) = delete;
+
+  void Init(TTreeReader* fReader) {
+    (std::get<ColumnIndex<Cols, Cols...>::value>(fColumns).emplace(*fReader, (fPrefix + "_" + Cols::name).c_str()), ...);
+  }
+
+  size_t Size() { return std::get<0>(fColumns)->GetSize(); }
+
+  // Reads every column of the current entry, so the branch I/O happens here and not on first use
+  void Load() { (LoadColumn<Cols>(), ...); }
+
+  template <typename C>
+  TTreeReaderArray<typename C::type>& Column() {
+    return *std::get<ColumnIndex<C, Cols...>::value>(fColumns);
+  }
+
+  template <typename C>
+  typename C::type Get(size_t i) {
+    return Column<C>().At(i);
+  }
+
+  // Mask of the objects passing pred(i)
+  template <typename Pred>
+  Mask Select(Pred pred) {
+    Mask mask(Size());
+    for (size_t i = 0; i < mask.Size(); i++) {
+      if (pred(i)) mask.Set(i);
+    }
+    return mask;
+  }
+
+  // Indices of the selected objects, ordered by decreasing key(i)
+  template <typename Key>
+  IndexList Candidates(const Mask& mask, Key key) {
+    IndexList list;
+    for (size_t i = 0; i < mask.Size(); i++) {
+      if (mask.Test(i)) list.Push(i);
+    }
+
+    // Stable insertion sort: a handful of objects, and unlike std::stable_sort no temporary buffer
+    int* idx = list.begin();
+    for (size_t i = 1; i < list.Size(); i++) {
+      int current = idx[i];
+      auto currentKey = key(current);
+      size_t j = i;
+      for (; j > 0 && key(idx[j - 1]) < currentKey; j--) {
+        idx[j] = idx[j - 1];
+      }
+      idx[j] = current;
+    }
+    return list;
+  }
+
+private:
+  template <typename C>
+  void LoadColumn() {
+    auto& column = Column<C>();
+    if (column.GetSize() > 0) column.At(0);
+  }
+
+  std::string fPrefix;
+  std::tuple<std::optional<TTreeReaderArray<typename Cols::type>>...> fColumns;
+};
+
+#endif
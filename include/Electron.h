@@ -0,0 +1,33 @@
+#ifndef Electron_h
+#define Electron_h
+
+#include "TTreeReader.h"
+#include "TLorentzVector.h"
+#include "Collection.h"
+
+
+typedef Collection<Col::pt, Col::eta, Col::phi, Col::mass, Col::charge,
+                   Col::cutBased, Col::pfRelIso03_all> ElectronCollection;
+
+class Electron
+{
+public:
+  Electron() :
+    fColumns("Electron")
+  {
+  }
+  ~Electron() {}
+
+  void Init(TTreeReader* fReader);
+  size_t Size() { return fColumns.Size(); }
+  TLorentzVector Get4Vec(int idx);
+  int GetCharge(int idx) { return fColumns.Get<Col::charge>(idx); }
+  Mask GetSelectionMask(double minPt, double maxEta, int minCutBased, double maxRelIso);
+  // Selected electrons ordered by decreasing pt
+  IndexList GetCandidates(const Mask& mask);
+
+private:
+  ElectronCollection fColumns;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef EventArena_h
+#define EventArena_h 1
+
+#include <vector>
+#include <cstddef>
+#include <memory_resource>
+
+
+// Per-job bump allocator for per-event scratch.
+// The buffer is allocated once; Reset() at the start of each event rewinds it.
+// Only requests beyond the buffer go to the heap.
+class EventArena
+{
+public:
+  explicit EventArena(size_t size = 64 * 1024) :
+    fBuffer(size),
+    fResource(fBuffer.data(), fBuffer.size())
+  {
+  }
+
+  std::pmr::memory_resource* Get() { return &fResource; }
+  void Reset() { fResource.release(); }
+
+private:
+  std::vector<std::byte> fBuffer;
+  std::pmr::monotonic_buffer_resource fResource;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef GenParticle_h
+#define GenParticle_h
+
+#include <vector>
+#include <utility>
+#include "TTreeReaderArray.h"
+#include "TTreeReader.h"
+#include "TLorentzVector.h"
+#include "Muon.h"
+#include "Collection.h"
+
+
+// Eta-phi grid over the generator muons of one event.
+// Cells are at least maxDR wide, so a match can only sit in the 3x3 cells
+// around the reco muon; the phi index wraps around at +-pi.
+class GenMatcher
+{
+public:
+  GenMatcher(double maxDR = 0.1, double maxEta = 5.);
+
+  void Reserve(size_t size);
+  void Build(const std::vector<TLorentzVector>& gen);
+  // Index of the closest gen muon within maxDR, -1 if none
+  int Match(double eta, double phi, int excludeIdx = -1) const;
+
+private:
+  double fMaxDR;
+  double fMaxEta;
+  int fNEta;
+  int fNPhi;
+  double fCellEta;
+  double fCellPhi;
+
+  std::vector<float> fEta;
+  std::vector<float> fPhi;
+  std::vector<std::pair<int, int>> fCells;   // (cell, gen index), sorted by cell
+
+  int EtaCell(double eta) const;
+  int PhiCell(double phi) const;
+};
+
+typedef Collection<Col::pt, Col::eta, Col::phi, Col::mass, Col::pdgId, Col::statusFlags> GenPartCollection;
+
+class GenParticle
+{
+public:
+  GenParticle() :
+    fColumns("GenPart")
+  {
+  }
+  ~GenParticle() {}
+
+  void Init(TTreeReader* fReader);
+  void Load() { fColumns.Load(); }
+  // Prompt, last-copy generator muons of the current event
+  const std::vector<TLorentzVector>& GetGenMuons();
+  DimuonPair GetGenDimuon();
+  // Matches a reco muon to the gen muons from the last GetGenMuons() call
+  int Match(const TLorentzVector& reco, int excludeIdx = -1) const;
+
+private:
+  GenPartCollection fColumns;
+
+  std::vector<TLorentzVector> fGenMuon4Vec;
+  std::vector<int> fGenMuonCharge;
+  GenMatcher fMatcher;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef Jet_h
+#define Jet_h
+
+#include "TTreeReader.h"
+#include "TLorentzVector.h"
+#include "Collection.h"
+
+
+typedef Collection<Col::pt, Col::eta, Col::phi, Col::mass,
+                   Col::jetId, Col::btagDeepFlavB> JetCollection;
+
+class Jet
+{
+public:
+  Jet() :
+    fColumns("Jet")
+  {
+  }
+  ~Jet() {}
+
+  void Init(TTreeReader* fReader);
+  size_t Size() { return fColumns.Size(); }
+  TLorentzVector Get4Vec(int idx);
+  float GetBTag(int idx) { return fColumns.Get<Col::btagDeepFlavB>(idx); }
+  // jetIdBits must all be set in jetId, e.g. 2 for tight
+  Mask GetSelectionMask(double minPt, double maxEta, int jetIdBits);
+  // Selected jets ordered by decreasing pt
+  IndexList GetCandidates(const Mask& mask);
+
+private:
+  JetCollection fColumns;
+};
+
+#endif
@@ -7,8 +7,10 @@
 #include "TTreeReaderArray.h"
 #include "TTreeReader.h"
 #include "TLorentzVector.h"
+#include "Collection.h"
 #include <nlohmann/json.hpp>
 #include <map>
+#include <memory_resource>
 
 using json = nlohmann::json;
 
@@ -54,15 +56,15 @@ struct DimuonPair {
   bool isValid = false;
 };
 
+typedef Collection<Col::pt, Col::tunepRelPt, Col::eta, Col::phi, Col::mass, Col::charge,
+                   Col::highPtId, Col::tkRelIso, Col::nTrackerLayers> MuonCollection;
+
 class Muon
 {
 public:
-  Muon() {
-    Muon_pt = nullptr;
-    Muon_eta = nullptr;
-    Muon_phi = nullptr;
-    Muon_mass = nullptr;
-    Muon_charge = nullptr;
+  Muon() :
+    fColumns("Muon")
+  {
   }
   ~Muon() {
     for (auto& pair : triggerMap) {
@@ -72,27 +74,26 @@ public:
   }
 
   void Init(TTreeReader* fReader);
-  std::vector<TLorentzVector> Get4Vec();
-  std::vector<int> GetCharge();
+  // Reads the muon columns and active triggers of the current entry
+  void Load();
+  const std::vector<TLorentzVector>& Get4Vec();
+  const std::vector<int>& GetCharge();
   std::vector<std::string> GetTriggers(const Selection& config, const std::string& sampleName);
-  bool PassTriggers(const std::vector<std::string>& triggerList);
-  // std::vector<std::pair<int, TLorentzVector>> GetSelectedMuons(const Selection& config);
-  std::vector<std::pair<int, TLorentzVector>> GetSelectedMuons(const Selection& config, const SelectionOptions& options);
+  // Resolves the sample's trigger list once, so PassTriggers() does no lookups per event;
+  // false if none of its triggers is in the tree
+  bool InitTriggers(const Selection& config, const std::string& sampleName);
+  bool PassTriggers();
+  Mask GetSelectionMask(const Selection& config, const SelectionOptions& options);
+  // The list is allocated from the caller's per-event arena
+  std::pmr::vector<std::pair<int, TLorentzVector>> GetSelectedMuons(const Selection& config, const SelectionOptions& options,
+                                                                    std::pmr::memory_resource* arena);
   DimuonPair GetDimuon(const Selection& config);
 
 private:
-  TTreeReaderArray<float>* Muon_pt;
-  TTreeReaderArray<float>* Muon_tunepRelPt;
-  TTreeReaderArray<float>* Muon_eta;
-  TTreeReaderArray<float>* Muon_phi;
-  TTreeReaderArray<float>* Muon_mass;
-  TTreeReaderArray<int>* Muon_charge;
-
-  TTreeReaderArray<unsigned char>* Muon_highPtId;
-  TTreeReaderArray<float>* Muon_tkRelIso;
-  TTreeReaderArray<int>* Muon_nTrackerLayers;
+  MuonCollection fColumns;
 
   std::map<std::string, TTreeReaderValue<bool>*> triggerMap;
+  std::vector<TTreeReaderValue<bool>*> fActiveTriggers;
 
   std::vector<TLorentzVector> fMuon4Vec;
   std::vector<int> fMuonCharge;
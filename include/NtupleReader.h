@@ -5,13 +5,14 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <memory>
 
 #include "TFile.h"
 #include "TROOT.h"
 #include "TTreeReader.h"
 #include "TTreeReaderValue.h"
 #include "TTreeReaderArray.h"
-#include "TChain.h"
+#include "TTree.h"
 #include "Muon.h"
 
 
@@ -19,27 +20,40 @@ class NtupleReader
 {
 public:
   NtupleReader() :
-    fChain(nullptr),
     fReader(nullptr),
-    fFilesPerJob(10)
+    fFilesPerJob(10),
+    genWeight(nullptr),
+    fOpenFileIdx(-1)
   {
-    fChain = new TChain("Events");
-  }
-  ~NtupleReader() {
-    delete fChain;
   }
+  ~NtupleReader() {}
 
-  void Init(const std::string& sampleName, const std::string& era, const int& idx = 0, const int& filesPerJob = 10);
+  // Opens the job's first file to bind the reader, false if it cannot be opened
+  bool Init(const std::string& sampleName, const std::string& era, const int& idx = 0, const int& filesPerJob = 10);
+  // Opens every file of the sample once and caches its entry count
+  bool BuildIndex(const std::string& sampleName, const std::string& era);
+  // Entries of every job of the sample from the cached index alone, -1 for jobs with unindexed files
+  bool GetJobEntries(const std::string& sampleName, const std::string& era, const int& filesPerJob, std::vector<long long>& jobEntries);
   // bool Next() { return fReader->Next(); }
 
-  TChain* GetChain() { return fChain; }
+  // Entries of all readable files of the job, from the index
+  long long GetEntries() const { return fTreeOffsets.back(); }
   TTreeReader* GetReader() { return fReader; }
   void SetMC();
+  // Reads the event-level branches (genWeight) of the current entry
+  void Load();
   TTreeReaderValue<float>* GetGenWeight();
   std::string GetSample() const;
+  // Opens the file holding entry with a timeout when the loop reaches it and points the reader
+  // at its tree, false if it is unreachable
+  bool PrepareFile(long long entry);
+  // Loads entry (counted over the job's files) from the file PrepareFile opened
+  bool SetEntry(long long entry);
+  // Reports the file holding entry as dead and returns the first entry of the next file
+  long long SkipFile(long long entry);
+  void PrintDeadFiles() const;
 
 private:
-  TChain* fChain;
   TTreeReader* fReader;  
   std::string fSampleName;
   std::string fEra;
@@ -47,7 +61,24 @@ private:
   int fFilesPerJob;
   TTreeReaderValue<float>* genWeight;
 
+  // Cached per-file metadata, ../input/index/<era>/<sample>.index
+  struct FileEntry {
+    std::string path;
+    long long entries;   // -1 until the file has been opened once
+  };
+  std::vector<std::string> fJobFiles;
+  std::vector<long long> fTreeOffsets;   // first entry of each of the job's files, plus the total
+  std::vector<std::string> fDeadFiles;
+  int fOpenFileIdx;
+  std::unique_ptr<TFile> fOpenFile;
+  std::string fListSignature;
+
   bool GetFile(const std::string& sampleName, const std::string& era, const int& idx, const int& filesPerJob);
+  bool GetFileList(const std::string& sampleName, const std::string& era, std::vector<FileEntry>& files);
+  void CountEntries(std::vector<FileEntry>& files, size_t begin, size_t end);
+  void SaveIndex(const std::string& sampleName, const std::string& era, const std::vector<FileEntry>& files);
+  static TFile* OpenWithTimeout(const std::string& path);
+  static long long OpenEntries(const std::string& path);
 };
 
 #endif
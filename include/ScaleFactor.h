@@ -0,0 +1,66 @@
+#ifndef ScaleFactor_h
+#define ScaleFactor_h 1
+
+#include <string>
+#include <vector>
+#include "TLorentzVector.h"
+#include "Muon.h"
+
+
+struct SFWeight {
+  double nominal = 1.;
+  double up = 1.;
+  double down = 1.;
+};
+
+// One (pt, |eta|) map flattened into contiguous arrays.
+// Each bin stores nominal/up/down next to each other, so a single bin search
+// returns all variations.
+class SFTable
+{
+public:
+  struct Bin {
+    float nominal;
+    float up;
+    float down;
+  };
+
+  bool Load(const std::string& fileName, const std::string& histName, bool ptOnX);
+  const Bin& Find(double pt, double absEta) const;
+  const std::string& GetName() const { return fName; }
+
+private:
+  std::string fName;
+
+  std::vector<double> fPtEdges;
+  std::vector<double> fEtaEdges;
+  std::vector<Bin> fBins;   // eta-major: fBins[iEta * nPt + iPt]
+
+  // Uniform axes are resolved arithmetically instead of by search
+  bool fPtUniform = false;
+  bool fEtaUniform = false;
+  double fPtInvWidth = 0.;
+  double fEtaInvWidth = 0.;
+
+  static int FindEdge(const std::vector<double>& edges, bool uniform, double invWidth, double value);
+};
+
+class ScaleFactor
+{
+public:
+  ScaleFactor() {}
+  ~ScaleFactor() {}
+
+  bool Init(const Selection& config);
+  bool IsActive() const { return !fTables.empty(); }
+
+  // Product of all loaded scale factors for one muon
+  SFWeight Get(const TLorentzVector& muon) const;
+  // Product over both legs of the selected dimuon
+  SFWeight Get(const DimuonPair& dimuon) const;
+
+private:
+  std::vector<SFTable> fTables;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef WorkQueue_h
+#define WorkQueue_h 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+
+
+// Line protocol over a local (AF_UNIX) socket:
+//   worker -> coordinator : READY | ALIVE <id> | DONE <id> <output> | FAILED <id>
+//   coordinator -> worker : UNIT <id> <era> <sample> <idx> <first> <n> <heartbeat> <output> | CANCEL <id> | WAIT <sec> | STOP
+
+struct WorkUnit {
+  int id = -1;
+  std::string era;
+  std::string sample;
+  int idx = 0;
+  long long firstEntry = 0;
+  long long nEntries = -1;   // -1: up to the end of the file slice
+  int heartbeat = 10;        // seconds between ALIVE messages, a third of the lease
+  std::string output;
+
+  std::string Serialize() const;
+  static bool Parse(const std::string& line, WorkUnit& unit);
+};
+
+class Coordinator
+{
+public:
+  Coordinator() :
+    fListenFd(-1),
+    fLeaseSeconds(60),
+    fHeartbeatSeconds(20),
+    fMaxRetries(3),
+    fSpeculationFactor(2.),
+    fEntriesPerUnit(500000)
+  {
+  }
+  ~Coordinator();
+
+  bool Init(const std::string& era, const std::string& socketPath, int leaseSeconds = 60, int maxRetries = 3);
+  // Serves workers until every unit is merged or given up, false if any failed
+  bool Run();
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Lease {
+    int fd;
+    int copy;
+    std::string output;
+    Clock::time_point start;
+    Clock::time_point expiry;
+  };
+
+  struct Unit {
+    WorkUnit unit;
+    enum State { kPending, kRunning, kDone, kFailed } state = kPending;
+    int failures = 0;
+    int copies = 0;
+    std::vector<Lease> leases;
+  };
+
+  struct Client {
+    std::string buffer;
+    int unitId = -1;
+  };
+
+  std::string fEra;
+  std::string fSocketPath;
+  int fListenFd;
+  int fLeaseSeconds;
+  int fHeartbeatSeconds;
+  int fMaxRetries;
+  double fSpeculationFactor;
+  long long fEntriesPerUnit;   // larger file slices are split into entry ranges
+
+  std::vector<Unit> fUnits;
+  std::map<int, Client> fClients;
+  std::map<std::string, bool> fMergeStarted;
+  std::vector<double> fDurations;
+
+  bool MakeUnits();
+  bool Finished() const;
+  void Accept();
+  bool Read(int fd);
+  void Handle(int fd, const std::string& line);
+  void Assign(int fd);
+  void Complete(int unitId, int fd, const std::string& partial);
+  void CancelLeases(Unit& unit);
+  int FindLease(const Unit& unit, int fd) const;
+  void Release(int unitId, int fd, const std::string& reason);
+  void DropLease(Unit& unit, size_t leaseIdx, const std::string& reason);
+  void Disconnect(int fd);
+  void CheckLeases();
+  int PickStraggler() const;
+  bool Merge(const Unit& unit, const std::string& partial);
+};
+
+class Worker
+{
+public:
+  Worker() : fFd(-1) {}
+  ~Worker();
+
+  bool Connect(const std::string& socketPath);
+  // Processes units until the coordinator sends STOP or goes away
+  void Run();
+
+private:
+  int fFd;
+  std::string fBuffer;
+
+  // 1: got a line, 0: timed out, -1: coordinator closed the connection
+  int ReadLine(std::string& line, int timeoutMs);
+  // Returns false if the coordinator went away; cancelled units count as handled
+  bool Process(const WorkUnit& unit);
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "AllocTracker.h"
+
+#ifdef HBZ_ALLOC_TRACKING
+
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+
+
+namespace {
+
+const char* kStageNames[AllocTracker::kNStages] = {"Other", "Read", "Gen", "Muon", "Trigger", "Selection", "Dimuon"};
+
+std::atomic<bool> gActive(false);
+std::atomic<int> gStage(AllocTracker::kOther);
+std::atomic<unsigned long long> gAllocs[AllocTracker::kNStages];
+std::atomic<unsigned long long> gBytes[AllocTracker::kNStages];
+long long gEvents = 0;
+
+inline void* Allocate(std::size_t size) {
+  if (gActive.load(std::memory_order_relaxed)) {
+    int stage = gStage.load(std::memory_order_relaxed);
+    gAllocs[stage].fetch_add(1, std::memory_order_relaxed);
+    gBytes[stage].fetch_add(size, std::memory_order_relaxed);
+  }
+  return std::malloc(size ? size : 1);
+}
+
+}
+
+// Interposed global allocator; the library is loaded ahead of libstdc++, so ROOT's
+// operator new calls land here too
+void* operator new(std::size_t size) {
+  void* ptr = Allocate(size);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](std::size_t size) {
+  void* ptr = Allocate(size);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+void AllocTracker::SetStage(Stage stage) {
+  gStage.store(stage, std::memory_order_relaxed);
+}
+
+void AllocTracker::CountEvent() {
+  // Counted in processed events, so skipped files cannot jump past the start
+  if (++gEvents == kWarmupEvents + 1) {
+    for (int s = 0; s < kNStages; s++) {
+      gAllocs[s] = 0;
+      gBytes[s] = 0;
+    }
+    gActive = true;
+  }
+}
+
+bool AllocTracker::Report() {
+  bool active = gActive.exchange(false);
+  if (!active) {
+    std::printf("Only %lld events processed, fewer than the %lld warm-up events: allocations not checked\n",
+                gEvents, kWarmupEvents);
+    return true;
+  }
+
+  bool clean = true;
+  long long counted = gEvents - kWarmupEvents;
+
+  std::printf("Allocations per event after %lld warm-up events (%lld events counted)\n", kWarmupEvents, counted);
+  std::printf("  %-10s %14s %14s\n", "Stage", "allocs/event", "bytes/event");
+  for (int s = 0; s < kNStages; s++) {
+    double events = counted;
+    std::printf("  %-10s %14.4f %14.1f\n", kStageNames[s], gAllocs[s] / events, gBytes[s] / events);
+    if (s != kRead && gAllocs[s] > 0) clean = false;
+  }
+  std::printf("Steady-state event loop is %s\n", clean ? "allocation-free" : "ALLOCATING");
+
+  return clean;
+}
+
+#endif
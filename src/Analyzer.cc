@@ -1,6 +1,7 @@
 #include "Analyzer.h"
 #include "NtupleReader.h"
 #include "Muon.h"
+#include "AllocTracker.h"
 
 #include <iostream>
 #include <math.h>
@@ -11,9 +12,10 @@
 #include <cstdlib>
 #include <fstream>
 #include <TChainElement.h>
+#include <algorithm>
 
 
-bool Analyzer::Init(const std::string& sampleName, const std::string& era, const int& idx)
+bool Analyzer::Init(const std::string& sampleName, const std::string& era, const int& idx, const std::string& outputName)
 {
   fSampleName = sampleName;
   fEra = era;
@@ -28,18 +30,34 @@ bool Analyzer::Init(const std::string& sampleName, const std::string& era, const
   }
   
   fNtupleReader = std::make_unique<NtupleReader>();
-  fNtupleReader->Init(sampleName, era, idx, filesPerJob);
+  if (!fNtupleReader->Init(sampleName, era, idx, filesPerJob)) {
+    return false;
+  }
   fReader = fNtupleReader->GetReader(); 
   fMuon->Init(fReader);
+  if (!fMuon->InitTriggers(fMuonConfig, sampleName)) {
+    return false;
+  }
+  fBootstrap.Init(fMuonConfig, fReader);
   
-  system(("mkdir -p ../output/250526/" + era + "/" + sampleName).c_str());
-  fOutputName = "../output/250526/" + era + "/" + sampleName + "/" + sampleName + "_" + std::to_string(idx) + ".root";
+  if (outputName.empty()) {
+    system(("mkdir -p ../output/250526/" + era + "/" + sampleName).c_str());
+    fOutputName = "../output/250526/" + era + "/" + sampleName + "/" + sampleName + "_" + std::to_string(idx) + ".root";
+  } else {
+    fOutputName = outputName;
+    system(("mkdir -p " + fOutputName.substr(0, fOutputName.find_last_of('/'))).c_str());
+  }
 
   fIsMC = fMuonConfig.j["IsMC"].contains(sampleName) ? 
           fMuonConfig.j["IsMC"][sampleName].get<bool>() : true;  
           
   if (fIsMC) {
     fNtupleReader->SetMC();
+    fGenParticle = std::make_unique<GenParticle>();
+    fGenParticle->Init(fReader);
+    if (!fScaleFactor.Init(fMuonConfig)) {
+      return false;
+    }
   }
 
   SetHist();
@@ -47,10 +65,13 @@ bool Analyzer::Init(const std::string& sampleName, const std::string& era, const
   return true;
 }
 
-void Analyzer::Run()
+void Analyzer::Run(long long firstEntry, long long nEntries)
 {  
-  TChain* chain = fNtupleReader->GetChain();
-  int nEntries = chain->GetEntries();
+  long long lastEntry = fNtupleReader->GetEntries();
+  if (nEntries >= 0) {
+    lastEntry = std::min(lastEntry, firstEntry + nEntries);
+  }
+  nEntries = lastEntry - firstEntry;
 
   std::string sample = fNtupleReader->GetSample();
   bool isNNLO = (sample.find("NNLO") != std::string::npos);
@@ -59,11 +80,33 @@ void Analyzer::Run()
 
   double totalWeight = 0.;
   // Event loop
-  for (int entry = 0; entry < nEntries; ++entry) {
-    fReader->SetEntry(entry);
+  for (long long entry = firstEntry; entry < lastEntry; ++entry) {
+    AllocTracker::SetStage(AllocTracker::kRead);
+    fArena.Reset();
+
+    // Files are opened lazily here; an unreachable one is skipped, an unreadable one retried, then skipped
+    bool loaded = false;
+    if (fNtupleReader->PrepareFile(entry)) {
+      for (int attempt = 0; attempt < 3 && !loaded; attempt++) {
+        loaded = fNtupleReader->SetEntry(entry);
+      }
+    }
+    if (!loaded) {
+      entry = fNtupleReader->SkipFile(entry) - 1;
+      continue;
+    }
+
+    // Branches are read lazily on first access; touching them here keeps all the I/O in the Read stage
+    fNtupleReader->Load();
+    fMuon->Load();
+    if (fIsMC) fGenParticle->Load();
+    fBootstrap.Load();
+
+    AllocTracker::CountEvent();
+    AllocTracker::SetStage(AllocTracker::kOther);
     
-    if (entry % 10000 == 0) {
-      std::cout << "Processing event " << entry << "/" << nEntries << std::endl;
+    if ((entry - firstEntry) % 10000 == 0) {
+      std::cout << "Processing event " << (entry - firstEntry) << "/" << nEntries << std::endl;
     }
 
     double evtWeight = 1.;
@@ -77,178 +120,262 @@ void Analyzer::Run()
 
     totalWeight += evtWeight;
 
+    if (fBootstrap.IsActive()) {
+      fBootstrap.SetEvent();
+      int slot = ReplicaSlot(h_TotalWeight);
+      if (slot >= 0) fBootstrap.Fill(slot, 0.5, evtWeight);
+    }
+
+    // Gen muons
+    AllocTracker::SetStage(AllocTracker::kGen);
+    DimuonPair genDimuon;
+    const std::vector<TLorentzVector>* genMuons = nullptr;
+    if (fIsMC) {
+      genMuons = &fGenParticle->GetGenMuons();
+      genDimuon = fGenParticle->GetGenDimuon();
+      if (genDimuon.isValid) {
+        Fill(h_GenDimuonMass, genDimuon.dimuon.M(), evtWeight);
+      }
+    }
+
     // Reco muons
-    auto fMuon4Vec = fMuon->Get4Vec();
-    auto fMuonCharge = fMuon->GetCharge();
+    AllocTracker::SetStage(AllocTracker::kMuon);
+    const auto& fMuon4Vec = fMuon->Get4Vec();
     
     for (int i = 0; i < fMuon4Vec.size(); i++) {
-      h_MuonPt->Fill(fMuon4Vec.at(i).Pt(), evtWeight);
-      h_MuonEta->Fill(fMuon4Vec.at(i).Eta(), evtWeight);
-      h_MuonPhi->Fill(fMuon4Vec.at(i).Phi(), evtWeight);
+      Fill(h_MuonPt, fMuon4Vec.at(i).Pt(), evtWeight);
+      Fill(h_MuonEta, fMuon4Vec.at(i).Eta(), evtWeight);
+      Fill(h_MuonPhi, fMuon4Vec.at(i).Phi(), evtWeight);
     }
 
     // Trigger selection
-    std::vector<std::string> triggerList = fMuon->GetTriggers(fMuonConfig, fSampleName);
-    if (!(fMuon->PassTriggers(triggerList))) {
+    AllocTracker::SetStage(AllocTracker::kTrigger);
+    if (!(fMuon->PassTriggers())) {
       continue;
     }
 
     for (int i = 0; i < fMuon4Vec.size(); i++) {
-      h_MuonPt_afterTrigger->Fill(fMuon4Vec.at(i).Pt(), evtWeight);
-      h_MuonEta_afterTrigger->Fill(fMuon4Vec.at(i).Eta(), evtWeight);
-      h_MuonPhi_afterTrigger->Fill(fMuon4Vec.at(i).Phi(), evtWeight);
+      Fill(h_MuonPt_afterTrigger, fMuon4Vec.at(i).Pt(), evtWeight);
+      Fill(h_MuonEta_afterTrigger, fMuon4Vec.at(i).Eta(), evtWeight);
+      Fill(h_MuonPhi_afterTrigger, fMuon4Vec.at(i).Phi(), evtWeight);
     }
 
     // Kinematic cuts
+    AllocTracker::SetStage(AllocTracker::kSelection);
     SelectionOptions options;
 
     // Pt
     options.applyPtCut = true;
-    auto muons_afterPt = fMuon->GetSelectedMuons(fMuonConfig, options);
+    auto muons_afterPt = fMuon->GetSelectedMuons(fMuonConfig, options, fArena.Get());
 
     for (int i = 0; i < muons_afterPt.size(); i++) {
-      h_MuonPt_afterPt->Fill(muons_afterPt.at(i).second.Pt(), evtWeight);
-      h_MuonEta_afterPt->Fill(muons_afterPt.at(i).second.Eta(), evtWeight);
-      h_MuonPhi_afterPt->Fill(muons_afterPt.at(i).second.Phi(), evtWeight);
+      Fill(h_MuonPt_afterPt, muons_afterPt.at(i).second.Pt(), evtWeight);
+      Fill(h_MuonEta_afterPt, muons_afterPt.at(i).second.Eta(), evtWeight);
+      Fill(h_MuonPhi_afterPt, muons_afterPt.at(i).second.Phi(), evtWeight);
     }
 
     // Pt + Eta
     options.applyEtaCut = true;
-    auto muons_afterPtEta = fMuon->GetSelectedMuons(fMuonConfig, options);
+    auto muons_afterPtEta = fMuon->GetSelectedMuons(fMuonConfig, options, fArena.Get());
 
     for (int i = 0; i < muons_afterPtEta.size(); i++) {
-      h_MuonPt_afterPtEta->Fill(muons_afterPtEta.at(i).second.Pt(), evtWeight);
-      h_MuonEta_afterPtEta->Fill(muons_afterPtEta.at(i).second.Eta(), evtWeight);
-      h_MuonPhi_afterPtEta->Fill(muons_afterPtEta.at(i).second.Phi(), evtWeight);
+      Fill(h_MuonPt_afterPtEta, muons_afterPtEta.at(i).second.Pt(), evtWeight);
+      Fill(h_MuonEta_afterPtEta, muons_afterPtEta.at(i).second.Eta(), evtWeight);
+      Fill(h_MuonPhi_afterPtEta, muons_afterPtEta.at(i).second.Phi(), evtWeight);
     }
 
     // Pt + Eta + Id 
     options.applyIdCut = true;
-    auto muons_afterPtEtaId = fMuon->GetSelectedMuons(fMuonConfig, options);
+    auto muons_afterPtEtaId = fMuon->GetSelectedMuons(fMuonConfig, options, fArena.Get());
 
     for (int i = 0; i < muons_afterPtEtaId.size(); i++) {
-      h_MuonPt_afterPtEtaId->Fill(muons_afterPtEtaId.at(i).second.Pt(), evtWeight);
-      h_MuonEta_afterPtEtaId->Fill(muons_afterPtEtaId.at(i).second.Eta(), evtWeight);
-      h_MuonPhi_afterPtEtaId->Fill(muons_afterPtEtaId.at(i).second.Phi(), evtWeight);
+      Fill(h_MuonPt_afterPtEtaId, muons_afterPtEtaId.at(i).second.Pt(), evtWeight);
+      Fill(h_MuonEta_afterPtEtaId, muons_afterPtEtaId.at(i).second.Eta(), evtWeight);
+      Fill(h_MuonPhi_afterPtEtaId, muons_afterPtEtaId.at(i).second.Phi(), evtWeight);
     }
 
     // Pt + Eta + Id + TkIso
     options.applyTkIsoCut = true;
-    auto muons_afterPtEtaIdTkIso = fMuon->GetSelectedMuons(fMuonConfig, options);
+    auto muons_afterPtEtaIdTkIso = fMuon->GetSelectedMuons(fMuonConfig, options, fArena.Get());
 
     for (int i = 0; i < muons_afterPtEtaIdTkIso.size(); i++) {
-      h_MuonPt_afterPtEtaIdTkIso->Fill(muons_afterPtEtaIdTkIso.at(i).second.Pt(), evtWeight);
-      h_MuonEta_afterPtEtaIdTkIso->Fill(muons_afterPtEtaIdTkIso.at(i).second.Eta(), evtWeight);
-      h_MuonPhi_afterPtEtaIdTkIso->Fill(muons_afterPtEtaIdTkIso.at(i).second.Phi(), evtWeight);
+      Fill(h_MuonPt_afterPtEtaIdTkIso, muons_afterPtEtaIdTkIso.at(i).second.Pt(), evtWeight);
+      Fill(h_MuonEta_afterPtEtaIdTkIso, muons_afterPtEtaIdTkIso.at(i).second.Eta(), evtWeight);
+      Fill(h_MuonPhi_afterPtEtaIdTkIso, muons_afterPtEtaIdTkIso.at(i).second.Phi(), evtWeight);
     }
 
     // auto selectedMuons = fMuon->GetSelectedMuons(fMuonConfig);
 
     // for (int i = 0; i < selectedMuons.size(); i++) {
-    //   h_MuonPt_selected->Fill(selectedMuons.at(i).second.Pt(), evtWeight);
-    //   h_MuonEta_selected->Fill(selectedMuons.at(i).second.Eta(), evtWeight);
-    //   h_MuonPhi_selected->Fill(selectedMuons.at(i).second.Phi(), evtWeight);
+    //   Fill(h_MuonPt_selected, selectedMuons.at(i).second.Pt(), evtWeight);
+    //   Fill(h_MuonEta_selected, selectedMuons.at(i).second.Eta(), evtWeight);
+    //   Fill(h_MuonPhi_selected, selectedMuons.at(i).second.Phi(), evtWeight);
     // }
 
     // Find dimuons
+    AllocTracker::SetStage(AllocTracker::kDimuon);
     auto dimuon = fMuon->GetDimuon(fMuonConfig);
 
     if (dimuon.isValid) {
-      h_SingleMuonPt->Fill(dimuon.leading->Pt(), evtWeight);
-      h_SingleMuonEta->Fill(dimuon.leading->Eta(), evtWeight);
-      h_SingleMuonPhi->Fill(dimuon.leading->Phi(), evtWeight);
-      h_SingleMuonPt->Fill(dimuon.subleading->Pt(), evtWeight);
-      h_SingleMuonEta->Fill(dimuon.subleading->Eta(), evtWeight);
-      h_SingleMuonPhi->Fill(dimuon.subleading->Phi(), evtWeight);
-
-      h_LeadingMuonPt->Fill(dimuon.leading->Pt(), evtWeight);
-      h_LeadingMuonEta->Fill(dimuon.leading->Eta(), evtWeight);
-      h_LeadingMuonPhi->Fill(dimuon.leading->Phi(), evtWeight);
-
-      h_SubleadingMuonPt->Fill(dimuon.subleading->Pt(), evtWeight);
-      h_SubleadingMuonEta->Fill(dimuon.subleading->Eta(), evtWeight);
-      h_SubleadingMuonPhi->Fill(dimuon.subleading->Phi(), evtWeight);
-
-      h_DimuonPt->Fill(dimuon.dimuon.Pt(), evtWeight);
-      h_DimuonRapidity->Fill(dimuon.dimuon.Rapidity(), evtWeight);
-      h_DimuonPhi->Fill(dimuon.dimuon.Phi(), evtWeight);
-      h_DimuonMass->Fill(dimuon.dimuon.M(), evtWeight);
+      // Muon ID/Iso/Trigger scale factors for the two selected legs
+      SFWeight sf = fScaleFactor.Get(dimuon);
+      double dimuonWeight = evtWeight * sf.nominal;
+
+      Fill(h_SingleMuonPt, dimuon.leading->Pt(), dimuonWeight);
+      Fill(h_SingleMuonEta, dimuon.leading->Eta(), dimuonWeight);
+      Fill(h_SingleMuonPhi, dimuon.leading->Phi(), dimuonWeight);
+      Fill(h_SingleMuonPt, dimuon.subleading->Pt(), dimuonWeight);
+      Fill(h_SingleMuonEta, dimuon.subleading->Eta(), dimuonWeight);
+      Fill(h_SingleMuonPhi, dimuon.subleading->Phi(), dimuonWeight);
+
+      Fill(h_LeadingMuonPt, dimuon.leading->Pt(), dimuonWeight);
+      Fill(h_LeadingMuonEta, dimuon.leading->Eta(), dimuonWeight);
+      Fill(h_LeadingMuonPhi, dimuon.leading->Phi(), dimuonWeight);
+
+      Fill(h_SubleadingMuonPt, dimuon.subleading->Pt(), dimuonWeight);
+      Fill(h_SubleadingMuonEta, dimuon.subleading->Eta(), dimuonWeight);
+      Fill(h_SubleadingMuonPhi, dimuon.subleading->Phi(), dimuonWeight);
+
+      Fill(h_DimuonPt, dimuon.dimuon.Pt(), dimuonWeight);
+      Fill(h_DimuonRapidity, dimuon.dimuon.Rapidity(), dimuonWeight);
+      Fill(h_DimuonPhi, dimuon.dimuon.Phi(), dimuonWeight);
+      Fill(h_DimuonMass, dimuon.dimuon.M(), dimuonWeight);
+      Fill(h_DimuonMass_SFUp, dimuon.dimuon.M(), evtWeight * sf.up);
+      Fill(h_DimuonMass_SFDown, dimuon.dimuon.M(), evtWeight * sf.down);
       
       if (dimuon.dimuon.M() > 200.) {
-        h_DimuonPt_MassCut->Fill(dimuon.dimuon.Pt(), evtWeight);
-        h_DimuonRapidity_MassCut->Fill(dimuon.dimuon.Rapidity(), evtWeight);
-        h_DimuonPhi_MassCut->Fill(dimuon.dimuon.Phi(), evtWeight);
-        h_DimuonMass_MassCut->Fill(dimuon.dimuon.M(), evtWeight);
+        Fill(h_DimuonPt_MassCut, dimuon.dimuon.Pt(), dimuonWeight);
+        Fill(h_DimuonRapidity_MassCut, dimuon.dimuon.Rapidity(), dimuonWeight);
+        Fill(h_DimuonPhi_MassCut, dimuon.dimuon.Phi(), dimuonWeight);
+        Fill(h_DimuonMass_MassCut, dimuon.dimuon.M(), dimuonWeight);
+        Fill(h_DimuonMass_MassCut_SFUp, dimuon.dimuon.M(), evtWeight * sf.up);
+        Fill(h_DimuonMass_MassCut_SFDown, dimuon.dimuon.M(), evtWeight * sf.down);
+      }
+
+      // Reco-gen matching of both legs
+      if (genDimuon.isValid) {
+        int leadMatch = fGenParticle->Match(*dimuon.leading);
+        int subleadMatch = (leadMatch != -1) ? fGenParticle->Match(*dimuon.subleading, leadMatch) : -1;
+
+        if (subleadMatch != -1) {
+          const TLorentzVector* leadGen = &genMuons->at(leadMatch);
+          const TLorentzVector* subleadGen = &genMuons->at(subleadMatch);
+          double genMass = (*leadGen + *subleadGen).M();
+          double recoMass = dimuon.dimuon.M();
+
+          // Efficiency numerator: same gen pair and weight as h_GenDimuonMass
+          bool genPairMatched = (leadGen == genDimuon.leading && subleadGen == genDimuon.subleading) ||
+                                (leadGen == genDimuon.subleading && subleadGen == genDimuon.leading);
+          if (genPairMatched) {
+            Fill(h_GenDimuonMass_Matched, genDimuon.dimuon.M(), evtWeight);
+          }
+          Fill(h_DimuonMass_Resolution, (recoMass - genMass) / genMass, dimuonWeight);
+          Fill(h_DimuonMass_Response, genMass, recoMass, dimuonWeight);
+        }
       }
     }
   } // End of event loop
 
   h_TotalWeight->SetBinContent(1, totalWeight);
+
+  fAllocationFree = AllocTracker::Report();
 }
 
 void Analyzer::End()
 {
   WriteHist();
+  fNtupleReader->PrintDeadFiles();
 }
 
 void Analyzer::SetHist()
 {
-  h_TotalWeight = new TH1F("h_total_weight", "Total weight;Bin;Total weight", 1, 0, 1);
+  h_TotalWeight = Book(new TH1F("h_total_weight", "Total weight;Bin;Total weight", 1, 0, 1));
 
-  h_MuonPt = new TH1F("h_muon_pt", "Muon pT;p_{T} [GeV];Events", 10000, 0, 10000);
-  h_MuonEta = new TH1F("h_muon_eta", "Muon #eta;#eta;Events", 60, -3, 3);
-  h_MuonPhi = new TH1F("h_muon_phi", "Muon #phi;#phi;Events", 24, -M_PI, M_PI);
+  h_MuonPt = Book(new TH1F("h_muon_pt", "Muon pT;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_MuonEta = Book(new TH1F("h_muon_eta", "Muon #eta;#eta;Events", 60, -3, 3));
+  h_MuonPhi = Book(new TH1F("h_muon_phi", "Muon #phi;#phi;Events", 24, -M_PI, M_PI));
 
-  h_MuonPt_afterTrigger = new TH1F("h_muon_pt_after_trigger", "Muon pT after trigger;p_{T} [GeV];Events", 10000, 0, 10000);
-  h_MuonEta_afterTrigger = new TH1F("h_muon_eta_after_trigger", "Muon #eta after trigger;#eta;Events", 60, -3, 3);
-  h_MuonPhi_afterTrigger = new TH1F("h_muon_phi_after_trigger", "Muon #phi after trigger;#phi;Events", 24, -M_PI, M_PI);
+  h_MuonPt_afterTrigger = Book(new TH1F("h_muon_pt_after_trigger", "Muon pT after trigger;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_MuonEta_afterTrigger = Book(new TH1F("h_muon_eta_after_trigger", "Muon #eta after trigger;#eta;Events", 60, -3, 3));
+  h_MuonPhi_afterTrigger = Book(new TH1F("h_muon_phi_after_trigger", "Muon #phi after trigger;#phi;Events", 24, -M_PI, M_PI));
 
-  h_MuonPt_afterPt = new TH1F("h_muon_pt_after_pt", "Muon pT after pt cut;p_{T} [GeV];Events", 10000, 0, 10000);
-  h_MuonEta_afterPt = new TH1F("h_muon_eta_after_pt", "Muon #eta after pt cut;#eta;Events", 60, -3, 3);
-  h_MuonPhi_afterPt = new TH1F("h_muon_phi_after_pt", "Muon #phi after pt cut;#phi;Events", 24, -M_PI, M_PI); 
+  h_MuonPt_afterPt = Book(new TH1F("h_muon_pt_after_pt", "Muon pT after pt cut;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_MuonEta_afterPt = Book(new TH1F("h_muon_eta_after_pt", "Muon #eta after pt cut;#eta;Events", 60, -3, 3));
+  h_MuonPhi_afterPt = Book(new TH1F("h_muon_phi_after_pt", "Muon #phi after pt cut;#phi;Events", 24, -M_PI, M_PI));
 
-  h_MuonPt_afterPtEta = new TH1F("h_muon_pt_after_pt_eta", "Muon pT after pt and eta cuts;p_{T} [GeV];Events", 10000, 0, 10000);
-  h_MuonEta_afterPtEta = new TH1F("h_muon_eta_after_pt_eta", "Muon #eta after pt and eta cuts;#eta;Events", 60, -3, 3);
-  h_MuonPhi_afterPtEta = new TH1F("h_muon_phi_after_pt_eta", "Muon #phi after pt and eta cuts;#phi;Events", 24, -M_PI, M_PI);
+  h_MuonPt_afterPtEta = Book(new TH1F("h_muon_pt_after_pt_eta", "Muon pT after pt and eta cuts;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_MuonEta_afterPtEta = Book(new TH1F("h_muon_eta_after_pt_eta", "Muon #eta after pt and eta cuts;#eta;Events", 60, -3, 3));
+  h_MuonPhi_afterPtEta = Book(new TH1F("h_muon_phi_after_pt_eta", "Muon #phi after pt and eta cuts;#phi;Events", 24, -M_PI, M_PI));
 
-  h_MuonPt_afterPtEtaId = new TH1F("h_muon_pt_after_pt_eta_id", "Muon pT after pt and eta and id cuts;p_{T} [GeV];Events", 10000, 0, 10000);
-  h_MuonEta_afterPtEtaId = new TH1F("h_muon_eta_after_pt_eta_id", "Muon #eta after pt and eta and id cuts;#eta;Events", 60, -3, 3);
-  h_MuonPhi_afterPtEtaId = new TH1F("h_muon_phi_after_pt_eta_id", "Muon #phi after pt and eta and id cuts;#phi;Events", 24, -M_PI, M_PI);
+  h_MuonPt_afterPtEtaId = Book(new TH1F("h_muon_pt_after_pt_eta_id", "Muon pT after pt and eta and id cuts;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_MuonEta_afterPtEtaId = Book(new TH1F("h_muon_eta_after_pt_eta_id", "Muon #eta after pt and eta and id cuts;#eta;Events", 60, -3, 3));
+  h_MuonPhi_afterPtEtaId = Book(new TH1F("h_muon_phi_after_pt_eta_id", "Muon #phi after pt and eta and id cuts;#phi;Events", 24, -M_PI, M_PI));
 
-  h_MuonPt_afterPtEtaIdTkIso = new TH1F("h_muon_pt_after_pt_eta_id_tkiso", "Muon pT after pt and eta and id and tkiso cuts;p_{T} [GeV];Events", 10000, 0, 10000); 
-  h_MuonEta_afterPtEtaIdTkIso = new TH1F("h_muon_eta_after_pt_eta_id_tkiso", "Muon #eta after pt and eta and id and tkiso cuts;#eta;Events", 60, -3, 3);
-  h_MuonPhi_afterPtEtaIdTkIso = new TH1F("h_muon_phi_after_pt_eta_id_tkiso", "Muon #phi after pt and eta and id and tkiso cuts;#phi;Events", 24, -M_PI, M_PI);
+  h_MuonPt_afterPtEtaIdTkIso = Book(new TH1F("h_muon_pt_after_pt_eta_id_tkiso", "Muon pT after pt and eta and id and tkiso cuts;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_MuonEta_afterPtEtaIdTkIso = Book(new TH1F("h_muon_eta_after_pt_eta_id_tkiso", "Muon #eta after pt and eta and id and tkiso cuts;#eta;Events", 60, -3, 3));
+  h_MuonPhi_afterPtEtaIdTkIso = Book(new TH1F("h_muon_phi_after_pt_eta_id_tkiso", "Muon #phi after pt and eta and id and tkiso cuts;#phi;Events", 24, -M_PI, M_PI));
 
   // h_MuonPt_selected = new TH1F("h_muon_selected_pt", "Muon pT;p_{T} [GeV];Events", 10000, 0, 10000);
   // h_MuonEta_selected = new TH1F("h_muon_selected_eta", "Muon #eta;#eta;Events", 60, -3, 3);
   // h_MuonPhi_selected = new TH1F("h_muon_selected_phi", "Muon #phi;#phi;Events", 24, -M_PI, M_PI);
 
-  h_SingleMuonPt = new TH1F("h_singlemuon_pt", "Single muon pT;p_{T} [GeV];Events", 10000, 0, 10000);
-  h_SingleMuonEta = new TH1F("h_singlemuon_eta", "Single muon #eta;#eta;Events", 60, -3, 3);
-  h_SingleMuonPhi = new TH1F("h_singlemuon_phi", "Single muon #phi;#phi;Events", 24, -M_PI, M_PI);
-
-  h_LeadingMuonPt = new TH1F("h_leadingmuon_pt", "Leading muon pT;p_{T} [GeV];Events", 10000, 0, 10000);
-  h_LeadingMuonEta = new TH1F("h_leadingmuon_eta", "Leading muon #eta;#eta;Events", 60, -3, 3);
-  h_LeadingMuonPhi = new TH1F("h_leadingmuon_phi", "Leading muon #phi;#phi;Events", 24, -M_PI, M_PI);
+  h_SingleMuonPt = Book(new TH1F("h_singlemuon_pt", "Single muon pT;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_SingleMuonEta = Book(new TH1F("h_singlemuon_eta", "Single muon #eta;#eta;Events", 60, -3, 3));
+  h_SingleMuonPhi = Book(new TH1F("h_singlemuon_phi", "Single muon #phi;#phi;Events", 24, -M_PI, M_PI));
+
+  h_LeadingMuonPt = Book(new TH1F("h_leadingmuon_pt", "Leading muon pT;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_LeadingMuonEta = Book(new TH1F("h_leadingmuon_eta", "Leading muon #eta;#eta;Events", 60, -3, 3));
+  h_LeadingMuonPhi = Book(new TH1F("h_leadingmuon_phi", "Leading muon #phi;#phi;Events", 24, -M_PI, M_PI));
+
+  h_SubleadingMuonPt = Book(new TH1F("h_subleadingmuon_pt", "Subleading muon pT;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_SubleadingMuonEta = Book(new TH1F("h_subleadingmuon_eta", "Subleading muon #eta;#eta;Events", 60, -3, 3));
+  h_SubleadingMuonPhi = Book(new TH1F("h_subleadingmuon_phi", "Subleading muon #phi;#phi;Events", 24, -M_PI, M_PI));
+
+  h_DimuonPt = Book(new TH1F("h_dimuon_pt", "Dimuon pT;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_DimuonRapidity = Book(new TH1F("h_dimuon_rapidity", "Dimuon rapidity;y;Events", 60, -3, 3));
+  h_DimuonPhi = Book(new TH1F("h_dimuon_phi", "Dimuon #phi;#phi;Events", 24, -M_PI, M_PI));
+  h_DimuonMass = Book(new TH1F("h_dimuon_mass", "Dimuon mass;m [GeV];Events", 10000, 0, 10000));
+
+  h_DimuonPt_MassCut = Book(new TH1F("h_dimuon_pt_mass_cut", "Dimuon pT;p_{T} [GeV];Events", 10000, 0, 10000));
+  h_DimuonRapidity_MassCut = Book(new TH1F("h_dimuon_rapidity_mass_cut", "Dimuon rapidity;y;Events", 60, -3, 3));
+  h_DimuonPhi_MassCut = Book(new TH1F("h_dimuon_phi_mass_cut", "Dimuon #phi;#phi;Events", 24, -M_PI, M_PI));
+  h_DimuonMass_MassCut = Book(new TH1F("h_dimuon_mass_mass_cut", "Dimuon mass;m [GeV];Events", 10000, 0, 10000));
+
+  h_DimuonMass_SFUp = Book(new TH1F("h_dimuon_mass_sf_up", "Dimuon mass (SF up);m [GeV];Events", 10000, 0, 10000));
+  h_DimuonMass_SFDown = Book(new TH1F("h_dimuon_mass_sf_down", "Dimuon mass (SF down);m [GeV];Events", 10000, 0, 10000));
+  h_DimuonMass_MassCut_SFUp = Book(new TH1F("h_dimuon_mass_mass_cut_sf_up", "Dimuon mass (SF up);m [GeV];Events", 10000, 0, 10000));
+  h_DimuonMass_MassCut_SFDown = Book(new TH1F("h_dimuon_mass_mass_cut_sf_down", "Dimuon mass (SF down);m [GeV];Events", 10000, 0, 10000));
+
+  h_GenDimuonMass = Book(new TH1F("h_gen_dimuon_mass", "Gen dimuon mass;m_{gen} [GeV];Events", 10000, 0, 10000));
+  h_GenDimuonMass_Matched = Book(new TH1F("h_gen_dimuon_mass_matched", "Gen dimuon mass (reco matched);m_{gen} [GeV];Events", 10000, 0, 10000));
+  h_DimuonMass_Resolution = Book(new TH1F("h_dimuon_mass_resolution", "Dimuon mass resolution;(m_{reco}-m_{gen})/m_{gen};Events", 200, -0.5, 0.5));
+  h_DimuonMass_Response = Book(new TH2F("h_dimuon_mass_response", "Dimuon mass response;m_{gen} [GeV];m_{reco} [GeV]", 500, 0, 5000, 500, 0, 5000));
+}
 
-  h_SubleadingMuonPt = new TH1F("h_subleadingmuon_pt", "Subleading muon pT;p_{T} [GeV];Events", 10000, 0, 10000);
-  h_SubleadingMuonEta = new TH1F("h_subleadingmuon_eta", "Subleading muon #eta;#eta;Events", 60, -3, 3);
-  h_SubleadingMuonPhi = new TH1F("h_subleadingmuon_phi", "Subleading muon #phi;#phi;Events", 24, -M_PI, M_PI);
+void Analyzer::FillHist()
+{
+  // will add later.
+}
 
-  h_DimuonPt = new TH1F("h_dimuon_pt", "Dimuon pT;p_{T} [GeV];Events", 10000, 0, 10000);
-  h_DimuonRapidity = new TH1F("h_dimuon_rapidity", "Dimuon rapidity;y;Events", 60, -3, 3);
-  h_DimuonPhi = new TH1F("h_dimuon_phi", "Dimuon #phi;#phi;Events", 24, -M_PI, M_PI);
-  h_DimuonMass = new TH1F("h_dimuon_mass", "Dimuon mass;m [GeV];Events", 10000, 0, 10000);
+int Analyzer::ReplicaSlot(const TH1* hist) const
+{
+  if (fReplicaSlots.empty()) return -1;
+  auto it = fReplicaSlots.find(hist);
+  return (it != fReplicaSlots.end()) ? it->second : -1;
+}
 
-  h_DimuonPt_MassCut = new TH1F("h_dimuon_pt_mass_cut", "Dimuon pT;p_{T} [GeV];Events", 10000, 0, 10000);
-  h_DimuonRapidity_MassCut = new TH1F("h_dimuon_rapidity_mass_cut", "Dimuon rapidity;y;Events", 60, -3, 3);
-  h_DimuonPhi_MassCut = new TH1F("h_dimuon_phi_mass_cut", "Dimuon #phi;#phi;Events", 24, -M_PI, M_PI);
-  h_DimuonMass_MassCut = new TH1F("h_dimuon_mass_mass_cut", "Dimuon mass;m [GeV];Events", 10000, 0, 10000);
+void Analyzer::Fill(TH1* hist, double x, double w)
+{
+  hist->Fill(x, w);
+  int slot = ReplicaSlot(hist);
+  if (slot >= 0) fBootstrap.Fill(slot, x, w);
 }
 
-void Analyzer::FillHist()
+void Analyzer::Fill(TH2* hist, double x, double y, double w)
 {
-  // will add later.
+  hist->Fill(x, y, w);
+  int slot = ReplicaSlot(hist);
+  if (slot >= 0) fBootstrap.Fill(slot, x, y, w);
 }
 
 void Analyzer::WriteHist()
@@ -307,6 +434,20 @@ void Analyzer::WriteHist()
   h_DimuonPhi_MassCut->Write();
   h_DimuonMass_MassCut->Write();
 
+  h_DimuonMass_SFUp->Write();
+  h_DimuonMass_SFDown->Write();
+  h_DimuonMass_MassCut_SFUp->Write();
+  h_DimuonMass_MassCut_SFDown->Write();
+
+  if (fIsMC) {
+    h_GenDimuonMass->Write();
+    h_GenDimuonMass_Matched->Write();
+    h_DimuonMass_Resolution->Write();
+    h_DimuonMass_Response->Write();
+  }
+
+  fBootstrap.Write();
+
   outputFile.Close();
   
   std::cout << "Output saved to: " << fOutputName << std::endl;
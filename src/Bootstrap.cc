@@ -0,0 +1,192 @@
+#include "Bootstrap.h"
+
+#include <iostream>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <sys/mman.h>
+#include "THnSparse.h"
+#include "TAxis.h"
+
+
+namespace {
+
+// Poisson(1) counts above this are dropped (P < 1e-9)
+const int kMaxCount = 12;
+
+std::vector<double> Edges(const TAxis* axis) {
+  std::vector<double> edges;
+  for (int i = 1; i <= axis->GetNbins() + 1; i++) edges.push_back(axis->GetBinLowEdge(i));
+  return edges;
+}
+
+inline uint32_t Mix32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x85ebca6bu;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35u;
+  x ^= x >> 16;
+  return x;
+}
+
+inline uint64_t Mix64(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+}
+
+bool Bootstrap::Init(const Selection& config, TTreeReader* fReader) {
+  fNReplicas = 0;
+  if (!config.j.contains("Bootstrap")) {
+    return true;
+  }
+  fNReplicas = config.j["Bootstrap"]["Replicas"].get<int>();
+  if (fNReplicas <= 0) return true;
+  if (config.j["Bootstrap"].contains("Exclude")) {
+    fExcluded = config.j["Bootstrap"]["Exclude"].get<std::vector<std::string>>();
+  }
+
+  run = std::make_unique<TTreeReaderValue<UInt_t>>(*fReader, "run");
+  luminosityBlock = std::make_unique<TTreeReaderValue<UInt_t>>(*fReader, "luminosityBlock");
+  event = std::make_unique<TTreeReaderValue<ULong64_t>>(*fReader, "event");
+
+  // u >= fThresholds[k] for k < n  <=>  Poisson count n
+  double p = std::exp(-1.), cdf = 0.;
+  fThresholds.clear();
+  for (int k = 0; k < kMaxCount; k++) {
+    cdf += p;
+    p /= (k + 1);
+    fThresholds.push_back(static_cast<uint32_t>(std::min(cdf * 4294967296., 4294967295.)));
+  }
+  fWeights.assign(fNReplicas, 1.f);
+
+  std::cout << "Bootstrap enabled with " << fNReplicas << " replicas" << std::endl;
+
+  return true;
+}
+
+void Bootstrap::Load() {
+  if (!IsActive()) return;
+  **run;
+  **luminosityBlock;
+  **event;
+}
+
+void Bootstrap::SetEvent() {
+  uint64_t key = Mix64(Mix64((static_cast<uint64_t>(**run) << 32) | **luminosityBlock) ^ **event);
+  uint32_t seedLo = static_cast<uint32_t>(key);
+  uint32_t seedHi = static_cast<uint32_t>(key >> 32);
+
+  const uint32_t* thresholds = fThresholds.data();
+  float* weights = fWeights.data();
+
+  // Counter-based: replica r only depends on (key, r); plain 32-bit ops so the loop vectorizes
+  for (int r = 0; r < fNReplicas; r++) {
+    uint32_t u = Mix32(Mix32(seedLo ^ (static_cast<uint32_t>(r) * 0x9e3779b9u)) ^ seedHi);
+    int count = 0;
+    for (int k = 0; k < kMaxCount; k++) {
+      count += (u >= thresholds[k]);
+    }
+    weights[r] = count;
+  }
+}
+
+int Bootstrap::Register(TH1* hist) {
+  if (!IsActive()) return -1;
+
+  if (std::find(fExcluded.begin(), fExcluded.end(), hist->GetName()) != fExcluded.end()) return -1;
+
+  size_t bytes = static_cast<size_t>(hist->GetNcells()) * fNReplicas * sizeof(float);
+  void* rows = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (rows == MAP_FAILED) {
+    std::cerr << "Warning: Could not reserve bootstrap replicas for " << hist->GetName() << std::endl;
+    return -1;
+  }
+
+  Slot slot;
+  slot.hist = hist;
+  slot.rowOfCell.assign(hist->GetNcells(), -1);
+  slot.rows = std::unique_ptr<float, Unmap>(static_cast<float*>(rows), Unmap{bytes});
+  fSlots.push_back(std::move(slot));
+
+  return fSlots.size() - 1;
+}
+
+void Bootstrap::Unmap::operator()(float* rows) const {
+  munmap(rows, bytes);
+}
+
+float* Bootstrap::Row(Slot& slot, int cell) {
+  int row = slot.rowOfCell[cell];
+  if (row < 0) {
+    row = slot.nRows++;
+    slot.rowOfCell[cell] = row;
+  }
+  return slot.rows.get() + static_cast<size_t>(row) * fNReplicas;
+}
+
+void Bootstrap::FillCell(Slot& slot, int cell, double w) {
+  float* content = Row(slot, cell);
+  const float* weights = fWeights.data();
+  float fw = w;
+
+  for (int r = 0; r < fNReplicas; r++) {
+    content[r] += fw * weights[r];
+  }
+}
+
+void Bootstrap::Fill(int slot, double x, double w) {
+  FillCell(fSlots[slot], fSlots[slot].hist->FindBin(x), w);
+}
+
+void Bootstrap::Fill(int slot, double x, double y, double w) {
+  FillCell(fSlots[slot], fSlots[slot].hist->FindBin(x, y), w);
+}
+
+void Bootstrap::Write() {
+  for (auto& slot : fSlots) {
+    // Never filled, e.g. gen histograms in data
+    if (slot.nRows == 0) continue;
+
+    std::string name = std::string(slot.hist->GetName()) + "_bootstrap";
+    std::string title = std::string(slot.hist->GetTitle()) + " (bootstrap replicas)";
+    int nCells = slot.rowOfCell.size();
+
+    // Axes of the histogram, then the replica axis; only the filled (cell, replica) bins are stored
+    int dim = slot.hist->GetDimension();
+    std::vector<std::vector<double>> edges = {Edges(slot.hist->GetXaxis())};
+    if (dim == 2) edges.push_back(Edges(slot.hist->GetYaxis()));
+
+    Int_t nBins[3];
+    Double_t xMin[3], xMax[3];
+    for (int d = 0; d < dim; d++) {
+      nBins[d] = edges[d].size() - 1;
+      xMin[d] = edges[d].front();
+      xMax[d] = edges[d].back();
+    }
+    nBins[dim] = fNReplicas;
+    xMin[dim] = 0.;
+    xMax[dim] = fNReplicas;
+
+    THnSparseF replicas(name.c_str(), title.c_str(), dim + 1, nBins, xMin, xMax);
+    for (int d = 0; d < dim; d++) {
+      replicas.GetAxis(d)->Set(nBins[d], edges[d].data());
+    }
+
+    // Under- and overflow cells go to the under- and overflow bins of the same axes
+    for (int cell = 0; cell < nCells; cell++) {
+      if (slot.rowOfCell[cell] < 0) continue;
+      const float* content = Row(slot, cell);
+      Int_t idx[3];
+      Int_t iz;
+      slot.hist->GetBinXYZ(cell, idx[0], idx[1], iz);
+      for (int r = 0; r < fNReplicas; r++) {
+        idx[dim] = r + 1;
+        if (content[r] != 0.f) replicas.SetBinContent(idx, content[r]);
+      }
+    }
+    replicas.Write();
+  }
+}
@@ -0,0 +1,28 @@
+#include "Electron.h"
+
+#include <cmath>
+
+
+void Electron::Init(TTreeReader* fReader) {
+  fColumns.Init(fReader);
+}
+
+TLorentzVector Electron::Get4Vec(int idx) {
+  TLorentzVector electron;
+  electron.SetPtEtaPhiM(fColumns.Get<Col::pt>(idx), fColumns.Get<Col::eta>(idx),
+                        fColumns.Get<Col::phi>(idx), fColumns.Get<Col::mass>(idx));
+  return electron;
+}
+
+Mask Electron::GetSelectionMask(double minPt, double maxEta, int minCutBased, double maxRelIso) {
+  return fColumns.Select([&](size_t i) {
+    return fColumns.Get<Col::pt>(i) > minPt &&
+           std::abs(fColumns.Get<Col::eta>(i)) < maxEta &&
+           fColumns.Get<Col::cutBased>(i) >= minCutBased &&
+           fColumns.Get<Col::pfRelIso03_all>(i) < maxRelIso;
+  });
+}
+
+IndexList Electron::GetCandidates(const Mask& mask) {
+  return fColumns.Candidates(mask, [&](int i) { return fColumns.Get<Col::pt>(i); });
+}
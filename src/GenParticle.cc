@@ -0,0 +1,159 @@
+#include "GenParticle.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+namespace {
+
+const int kIsPrompt = 1 << 0;
+const int kIsLastCopy = 1 << 13;
+
+}
+
+GenMatcher::GenMatcher(double maxDR, double maxEta) :
+  fMaxDR(maxDR),
+  fMaxEta(maxEta)
+{
+  fNEta = std::max(1, static_cast<int>(2. * maxEta / maxDR));
+  fNPhi = std::max(1, static_cast<int>(2. * M_PI / maxDR));
+  fCellEta = 2. * maxEta / fNEta;
+  fCellPhi = 2. * M_PI / fNPhi;
+}
+
+void GenMatcher::Reserve(size_t size) {
+  fEta.reserve(size);
+  fPhi.reserve(size);
+  fCells.reserve(size);
+}
+
+int GenMatcher::EtaCell(double eta) const {
+  // Beyond maxEta everything lands in the edge cells
+  double x = (eta + fMaxEta) / fCellEta;
+  if (!(x > 0.)) return 0;
+  if (x >= fNEta) return fNEta - 1;
+  return static_cast<int>(x);
+}
+
+int GenMatcher::PhiCell(double phi) const {
+  int ip = static_cast<int>(std::floor((phi + M_PI) / fCellPhi)) % fNPhi;
+  return ip < 0 ? ip + fNPhi : ip;
+}
+
+void GenMatcher::Build(const std::vector<TLorentzVector>& gen) {
+  int nGen = gen.size();
+  fEta.resize(nGen);
+  fPhi.resize(nGen);
+  fCells.resize(nGen);
+
+  // Gen muons sorted by cell key, so the grid costs nothing for empty cells
+  for (int i = 0; i < nGen; i++) {
+    fEta[i] = gen[i].Eta();
+    fPhi[i] = gen[i].Phi();
+    fCells[i] = {EtaCell(fEta[i]) * fNPhi + PhiCell(fPhi[i]), i};
+  }
+  std::sort(fCells.begin(), fCells.end());
+}
+
+int GenMatcher::Match(double eta, double phi, int excludeIdx) const {
+  if (fCells.empty()) return -1;
+
+  int ie = EtaCell(eta);
+  int ip = PhiCell(phi);
+  int nPhiScan = std::min(3, fNPhi);
+  int phiStart = (fNPhi >= 3) ? ip - 1 : 0;
+
+  int bestIdx = -1;
+  double bestDR2 = fMaxDR * fMaxDR;
+
+  for (int e = std::max(0, ie - 1); e <= std::min(fNEta - 1, ie + 1); e++) {
+    for (int k = 0; k < nPhiScan; k++) {
+      int p = (phiStart + k + fNPhi) % fNPhi;
+      std::pair<int, int> key = {e * fNPhi + p, -1};
+
+      for (auto it = std::lower_bound(fCells.begin(), fCells.end(), key);
+           it != fCells.end() && it->first == key.first; ++it) {
+        int idx = it->second;
+        if (idx == excludeIdx) continue;
+
+        double dEta = fEta[idx] - eta;
+        double dPhi = std::abs(fPhi[idx] - phi);
+        if (dPhi > M_PI) dPhi = 2. * M_PI - dPhi;
+        double dR2 = dEta * dEta + dPhi * dPhi;
+
+        if (dR2 < bestDR2) {
+          bestDR2 = dR2;
+          bestIdx = idx;
+        }
+      }
+    }
+  }
+
+  return bestIdx;
+}
+
+void GenParticle::Init(TTreeReader* fReader) {
+  fColumns.Init(fReader);
+  fGenMuon4Vec.reserve(kMaxObjects);
+  fGenMuonCharge.reserve(kMaxObjects);
+  fMatcher.Reserve(kMaxObjects);
+}
+
+const std::vector<TLorentzVector>& GenParticle::GetGenMuons() {
+  fGenMuon4Vec.clear();
+  fGenMuonCharge.clear();
+
+  // Only pdgId and statusFlags are touched for non-muons.
+  // No Mask here: generator records can exceed kMaxObjects.
+  auto& pdgIds = fColumns.Column<Col::pdgId>();
+  auto& statusFlags = fColumns.Column<Col::statusFlags>();
+
+  for (size_t i = 0; i < pdgIds.GetSize(); i++) {
+    int pdgId = pdgIds.At(i);
+    if (std::abs(pdgId) != 13) continue;
+
+    int flags = statusFlags.At(i);
+    if (!(flags & kIsPrompt) || !(flags & kIsLastCopy)) continue;
+
+    TLorentzVector muon;
+    muon.SetPtEtaPhiM(fColumns.Get<Col::pt>(i), fColumns.Get<Col::eta>(i), fColumns.Get<Col::phi>(i), fColumns.Get<Col::mass>(i));
+    fGenMuon4Vec.push_back(muon);
+    fGenMuonCharge.push_back(pdgId > 0 ? -1 : 1);
+  }
+
+  fMatcher.Build(fGenMuon4Vec);
+
+  return fGenMuon4Vec;
+}
+
+DimuonPair GenParticle::GetGenDimuon() {
+  DimuonPair dimuon;
+
+  int leadIdx = -1, subleadIdx = -1;
+  for (size_t i = 0; i < fGenMuon4Vec.size(); i++) {
+    if (leadIdx == -1 || fGenMuon4Vec[i].Pt() > fGenMuon4Vec[leadIdx].Pt()) {
+      leadIdx = i;
+    }
+  }
+  if (leadIdx == -1) return dimuon;
+
+  for (size_t i = 0; i < fGenMuon4Vec.size(); i++) {
+    if (fGenMuonCharge[i] * fGenMuonCharge[leadIdx] >= 0) continue;
+    if (subleadIdx == -1 || fGenMuon4Vec[i].Pt() > fGenMuon4Vec[subleadIdx].Pt()) {
+      subleadIdx = i;
+    }
+  }
+
+  if (subleadIdx != -1) {
+    dimuon.leading = &fGenMuon4Vec[leadIdx];
+    dimuon.subleading = &fGenMuon4Vec[subleadIdx];
+    dimuon.dimuon = *dimuon.leading + *dimuon.subleading;
+    dimuon.isValid = true;
+  }
+
+  return dimuon;
+}
+
+int GenParticle::Match(const TLorentzVector& reco, int excludeIdx) const {
+  return fMatcher.Match(reco.Eta(), reco.Phi(), excludeIdx);
+}
@@ -0,0 +1,27 @@
+#include "Jet.h"
+
+#include <cmath>
+
+
+void Jet::Init(TTreeReader* fReader) {
+  fColumns.Init(fReader);
+}
+
+TLorentzVector Jet::Get4Vec(int idx) {
+  TLorentzVector jet;
+  jet.SetPtEtaPhiM(fColumns.Get<Col::pt>(idx), fColumns.Get<Col::eta>(idx),
+                   fColumns.Get<Col::phi>(idx), fColumns.Get<Col::mass>(idx));
+  return jet;
+}
+
+Mask Jet::GetSelectionMask(double minPt, double maxEta, int jetIdBits) {
+  return fColumns.Select([&](size_t i) {
+    return fColumns.Get<Col::pt>(i) > minPt &&
+           std::abs(fColumns.Get<Col::eta>(i)) < maxEta &&
+           (fColumns.Get<Col::jetId>(i) & jetIdBits) == jetIdBits;
+  });
+}
+
+IndexList Jet::GetCandidates(const Mask& mask) {
+  return fColumns.Candidates(mask, [&](int i) { return fColumns.Get<Col::pt>(i); });
+}
@@ -8,15 +8,9 @@
 
 void Muon::Init(TTreeReader* fReader) {
 
-  Muon_pt = new TTreeReaderArray<float>(*fReader, "Muon_pt");
-  Muon_tunepRelPt = new TTreeReaderArray<float>(*fReader, "Muon_tunepRelPt");
-  Muon_eta = new TTreeReaderArray<float>(*fReader, "Muon_eta");
-  Muon_phi = new TTreeReaderArray<float>(*fReader, "Muon_phi");
-  Muon_mass = new TTreeReaderArray<float>(*fReader, "Muon_mass");
-  Muon_charge = new TTreeReaderArray<int>(*fReader, "Muon_charge");
-  Muon_highPtId = new TTreeReaderArray<unsigned char>(*fReader, "Muon_highPtId");
-  Muon_tkRelIso = new TTreeReaderArray<float>(*fReader, "Muon_tkRelIso");
-  Muon_nTrackerLayers = new TTreeReaderArray<int>(*fReader, "Muon_nTrackerLayers");
+  fColumns.Init(fReader);
+  fMuon4Vec.reserve(kMaxObjects);
+  fMuonCharge.reserve(kMaxObjects);
 
   const std::vector<std::string> commonTriggers = {"HLT_Mu50", "HLT_TkMu50", "HLT_OldMu100", "HLT_TkMu100"};
   TTree* tree = fReader->GetTree();
@@ -28,29 +22,35 @@ void Muon::Init(TTreeReader* fReader) {
   }
 }
 
-std::vector<TLorentzVector> Muon::Get4Vec() {
+void Muon::Load() {
+  fColumns.Load();
+  for (auto* trigger : fActiveTriggers) {
+    **trigger;
+  }
+}
+
+const std::vector<TLorentzVector>& Muon::Get4Vec() {
   fMuon4Vec.clear();
   
-  for (int i = 0; i < Muon_pt->GetSize(); i++) {
-    float pt = Muon_pt->At(i);
-    float tunepRelPt = Muon_tunepRelPt->At(i);
-    float eta = Muon_eta->At(i);
-    float phi = Muon_phi->At(i);
-    float mass = Muon_mass->At(i);
-
-		TLorentzVector muon;
-		muon.SetPtEtaPhiM(pt * tunepRelPt, eta, phi, mass);
-		// muon.SetPtEtaPhiM(pt, eta, phi, mass);
-		fMuon4Vec.push_back(muon);
-	}
-	return fMuon4Vec;
+  for (size_t i = 0; i < fColumns.Size(); i++) {
+    float pt = fColumns.Get<Col::pt>(i);
+    float tunepRelPt = fColumns.Get<Col::tunepRelPt>(i);
+    float eta = fColumns.Get<Col::eta>(i);
+    float phi = fColumns.Get<Col::phi>(i);
+    float mass = fColumns.Get<Col::mass>(i);
+
+    TLorentzVector muon;
+    muon.SetPtEtaPhiM(pt * tunepRelPt, eta, phi, mass);
+    fMuon4Vec.push_back(muon);
+  }
+  return fMuon4Vec;
 }
 
-std::vector<int> Muon::GetCharge() {
+const std::vector<int>& Muon::GetCharge() {
   fMuonCharge.clear();
   
-  for (int i = 0; i < Muon_charge->GetSize(); i++) {
-    fMuonCharge.push_back(Muon_charge->At(i));
+  for (size_t i = 0; i < fColumns.Size(); i++) {
+    fMuonCharge.push_back(fColumns.Get<Col::charge>(i));
   }
   return fMuonCharge;
 } 
@@ -68,40 +68,56 @@ std::vector<std::string> Muon::GetTriggers(const Selection& config, const std::s
   return defaultTriggers;
 }
 
-bool Muon::PassTriggers(const std::vector<std::string>& triggerList) {
-  for (const auto& trigger : triggerList) {
+bool Muon::InitTriggers(const Selection& config, const std::string& sampleName) {
+  fActiveTriggers.clear();
+  for (const auto& trigger : GetTriggers(config, sampleName)) {
     auto it = triggerMap.find(trigger);
-    if (it != triggerMap.end() && *(*it->second)) {
+    if (it != triggerMap.end()) {
+      fActiveTriggers.push_back(it->second);
+    }
+  }
+
+  // Every event would fail the trigger
+  if (fActiveTriggers.empty()) {
+    std::cerr << "Error: None of the triggers of " << sampleName << " is in the input tree" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool Muon::PassTriggers() {
+  for (auto* trigger : fActiveTriggers) {
+    if (**trigger) {
       return true;
     }
   }
   return false;
 }
 
-// std::vector<std::pair<int, TLorentzVector>> Muon::GetSelectedMuons(const Selection& config) {
-std::vector<std::pair<int, TLorentzVector>> Muon::GetSelectedMuons(const Selection& config, const SelectionOptions& options = SelectionOptions()) {
-  std::vector<std::pair<int, TLorentzVector>> selectedMuons;
-  selectedMuons.reserve(fMuon4Vec.size());
+Mask Muon::GetSelectionMask(const Selection& config, const SelectionOptions& options = SelectionOptions()) {
   Get4Vec();
-  
-  for (size_t i = 0; i < fMuon4Vec.size(); i++) {
+
+  return fColumns.Select([&](size_t i) {
     const auto& muon = fMuon4Vec[i];
 
-    // if (muon.Pt() > config.Subleading_Pt && 
-    //     std::abs(muon.Eta()) < config.Eta &&
-    //     Muon_highPtId->At(i) >= config.Id &&
-    //     Muon_tkRelIso->At(i) < config.TkIso) {
-    //   selectedMuons.push_back({i, muon});
-    // }
-
-    bool passSelection = true;
-
-    if (options.applyPtCut && muon.Pt() <= config.Subleading_Pt) passSelection = false;
-    if (options.applyEtaCut && std::abs(muon.Eta()) >= config.Eta) passSelection = false;
-    if (options.applyIdCut && Muon_highPtId->At(i) != config.Id) passSelection = false;
-    if (options.applyTkIsoCut && Muon_tkRelIso->At(i) >= config.TkIso) passSelection = false;
-    if (passSelection) {
-      selectedMuons.push_back({i, muon});
+    if (options.applyPtCut && muon.Pt() <= config.Subleading_Pt) return false;
+    if (options.applyEtaCut && std::abs(muon.Eta()) >= config.Eta) return false;
+    if (options.applyIdCut && fColumns.Get<Col::highPtId>(i) != config.Id) return false;
+    if (options.applyTkIsoCut && fColumns.Get<Col::tkRelIso>(i) >= config.TkIso) return false;
+    return true;
+  });
+}
+
+std::pmr::vector<std::pair<int, TLorentzVector>> Muon::GetSelectedMuons(const Selection& config, const SelectionOptions& options,
+                                                                        std::pmr::memory_resource* arena) {
+  Mask mask = GetSelectionMask(config, options);
+
+  std::pmr::vector<std::pair<int, TLorentzVector>> selectedMuons(arena);
+  selectedMuons.reserve(mask.Count());
+  
+  for (size_t i = 0; i < mask.Size(); i++) {
+    if (mask.Test(i)) {
+      selectedMuons.push_back({i, fMuon4Vec[i]});
     }
   }
 
@@ -110,31 +126,24 @@ std::vector<std::pair<int, TLorentzVector>> Muon::GetSelectedMuons(const Selecti
 
 DimuonPair Muon::GetDimuon(const Selection& config) {
   DimuonPair dimuon;
-  // auto selectedMuons = GetSelectedMuons(config);
   SelectionOptions options;
   options.applyPtCut = true;
   options.applyEtaCut = true;
   options.applyIdCut = true;
   options.applyTkIsoCut = true;
-  auto selectedMuons = GetSelectedMuons(config, options);
+  Mask mask = GetSelectionMask(config, options);
+  IndexList candidates = fColumns.Candidates(mask, [&](int i) { return fMuon4Vec[i].Pt(); });
   
-  GetCharge(); 
-
   int leadIdx = -1, subleadIdx = -1;
 
-  if (selectedMuons.size() >= 2) {
-    std::sort(selectedMuons.begin(), selectedMuons.end(),
-              [](const auto& a, const auto& b) { return a.second.Pt() > b.second.Pt(); });
-    
-    if (selectedMuons[0].second.Pt() > config.Leading_Pt) {
-      leadIdx = selectedMuons[0].first;
-
-      for (int i = 1; i < selectedMuons.size(); i++) {
-        int idx = selectedMuons[i].first;
-        if (fMuonCharge[idx] * fMuonCharge[leadIdx] < 0) {
-          subleadIdx = idx;
-          break;
-        }
+  if (candidates.Size() >= 2 && fMuon4Vec[candidates[0]].Pt() > config.Leading_Pt) {
+    leadIdx = candidates[0];
+
+    for (size_t i = 1; i < candidates.Size(); i++) {
+      int idx = candidates[i];
+      if (fColumns.Get<Col::charge>(idx) * fColumns.Get<Col::charge>(leadIdx) < 0) {
+        subleadIdx = idx;
+        break;
       }
     }
   }
@@ -5,80 +5,346 @@
 #include <sstream>
 #include <filesystem>
 #include <stdexcept>
+#include <cstdio>
+#include <memory>
 #include <unistd.h>
+#include <sys/file.h>
+#include <fcntl.h>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <map>
+#include "TTree.h"
 
 
-void NtupleReader::Init(const std::string& sampleName, const std::string& era, const int& idx, const int& filesPerJob)
+namespace {
+
+const int kOpenThreads = 8;
+const int kOpenRetries = 3;
+const int kOpenTimeout = 60; // seconds
+
+std::string IndexPath(const std::string& sampleName, const std::string& era) {
+  return "../input/index/" + era + "/" + sampleName + ".index";
+}
+
+// Reads an index file; false if it is missing or was written for other list files
+bool ReadIndex(const std::string& indexPath, const std::string& signature, std::map<std::string, long long>& entries) {
+  std::ifstream indexFile(indexPath);
+  std::string line;
+  bool fresh = std::getline(indexFile, line) && line == "# " + signature;
+
+  while (std::getline(indexFile, line)) {
+    std::istringstream ss(line);
+    std::string path;
+    long long n;
+    if (ss >> path >> n) entries[path] = n;
+  }
+  return fresh;
+}
+
+}
+
+bool NtupleReader::Init(const std::string& sampleName, const std::string& era, const int& idx, const int& filesPerJob)
 {
   fSampleName = sampleName;
   fEra = era;
   fFilesPerJob = filesPerJob;
+
+  // XRootD reads of an opened file must not hang the job either (seconds, default 1800)
+  setenv("XRD_REQUESTTIMEOUT", std::to_string(kOpenTimeout).c_str(), 0);
   
-  GetFile(sampleName, era, idx, filesPerJob);
+  if (!GetFile(sampleName, era, idx, filesPerJob)) {
+    return false;
+  }
+
+  fReader = new TTreeReader();
+  if (fNFiles == 0) {
+    std::cerr << "Error: No readable files for job " << idx << std::endl;
+    return false;
+  }
 
-  fReader = new TTreeReader(fChain);
+  // The collections look up their branches (e.g. the triggers) in the reader's tree during
+  // their Init, so the first file is opened here, with the timeout, and must be readable
+  if (!PrepareFile(0)) {
+    std::cerr << "Error: Could not open the first file of job " << idx << ": " << fJobFiles.front() << std::endl;
+    return false;
+  }
+  return true;
 }
 
-bool NtupleReader::GetFile(const std::string& sampleName, const std::string& era, const int& idx, const int& filesPerJob) {
-    
+bool NtupleReader::GetFileList(const std::string& sampleName, const std::string& era, std::vector<FileEntry>& files) {
+
   std::string inputDir = "../input/" + era + "/" + sampleName;
-  fNFiles = 0;
-  
+
+  // The list files' names, sizes and mtimes decide whether the cached index is still valid
+  std::vector<std::filesystem::path> listFiles;
+  std::ostringstream signature;
   try {
-    std::vector<std::string> allFiles;
-    
     for (const auto& entry : std::filesystem::directory_iterator(inputDir)) {
-      if (entry.is_regular_file()) {
-        std::string filePath = entry.path().string();
-        std::ifstream inputFile(filePath);
-
-        std::string line;
-        while (std::getline(inputFile, line)) {
-          if (line.empty()) continue;
-          allFiles.push_back(line);
-        }
-        
-        inputFile.close();
+      if (entry.is_regular_file() && entry.path().extension() == ".list") {
+        listFiles.push_back(entry.path());
       }
     }
-    
-    std::sort(allFiles.begin(), allFiles.end());
-    
-    int startIdx = idx * filesPerJob;
-    int endIdx = std::min(startIdx + filesPerJob, static_cast<int>(allFiles.size()));
-    
-    std::cout << "Job " << idx << " will process files from index " << startIdx 
-              << " to " << (endIdx - 1) << " (total files: " << allFiles.size() << ")" << std::endl;
-    
-    for (int i = startIdx; i < endIdx; i++) {
-      if (i < allFiles.size()) {
-        std::string line = allFiles[i];
-        
-        size_t pos = line.find("/pnfs/");
-        if (pos != std::string::npos) {
-          line = line.substr(pos);
-        }
-
-        fChain->Add(line.c_str());
-        fNFiles++;
-      }
+    std::sort(listFiles.begin(), listFiles.end());
+
+    for (const auto& listFile : listFiles) {
+      signature << listFile.filename().string() << ":" << std::filesystem::file_size(listFile) << ":"
+                << std::filesystem::last_write_time(listFile).time_since_epoch().count() << ";";
     }
   } catch (const std::filesystem::filesystem_error& e) {
     std::cerr << "Error: Could not access directory: " << inputDir << std::endl;
     return false;
   }
+  fListSignature = signature.str();
+
+  std::map<std::string, long long> cached;
+  bool fresh = ReadIndex(IndexPath(sampleName, era), fListSignature, cached);
+
+  std::string line;
+  files.clear();
+  if (fresh) {
+    for (const auto& item : cached) {
+      files.push_back({item.first, item.second});
+    }
+    return true;
+  }
+
+  // Stale or missing index: re-read the lists, keeping the counts of files still listed
+  for (const auto& listFile : listFiles) {
+    std::ifstream inputFile(listFile);
+    while (std::getline(inputFile, line)) {
+      if (line.empty()) continue;
+
+      size_t pos = line.find("/pnfs/");
+      if (pos != std::string::npos) {
+        line = line.substr(pos);
+      }
+
+      auto it = cached.find(line);
+      files.push_back({line, it != cached.end() ? it->second : -1});
+    }
+  }
+  std::sort(files.begin(), files.end(),
+            [](const FileEntry& a, const FileEntry& b) { return a.path < b.path; });
+
+  return true;
+}
+
+TFile* NtupleReader::OpenWithTimeout(const std::string& path) {
+  std::string option = "TIMEOUT=" + std::to_string(kOpenTimeout);
+
+  for (int attempt = 1; attempt <= kOpenRetries; attempt++) {
+    TFile* file = TFile::Open(path.c_str(), option.c_str());
+    if (file && !file->IsZombie()) return file;
+    delete file;
+    std::cerr << "Warning: Could not open " << path << " (attempt " << attempt << "/" << kOpenRetries << ")" << std::endl;
+  }
+  return nullptr;
+}
+
+long long NtupleReader::OpenEntries(const std::string& path) {
+  std::unique_ptr<TFile> file(OpenWithTimeout(path));
+  if (!file) return -1;
+
+  TTree* tree = nullptr;
+  file->GetObject("Events", tree);
+  return tree ? tree->GetEntries() : -1;
+}
+
+void NtupleReader::CountEntries(std::vector<FileEntry>& files, size_t begin, size_t end) {
+  std::vector<size_t> unknown;
+  for (size_t i = begin; i < end; i++) {
+    if (files[i].entries < 0) unknown.push_back(i);
+  }
+  if (unknown.empty()) return;
+
+  std::cout << "Opening " << unknown.size() << " files without cached entry counts" << std::endl;
+
+  // Independent opens run in parallel
+  ROOT::EnableThreadSafety();
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> threads;
+  int nThreads = std::min<size_t>(kOpenThreads, unknown.size());
+
+  for (int t = 0; t < nThreads; t++) {
+    threads.emplace_back([&]() {
+      size_t n;
+      while ((n = next++) < unknown.size()) {
+        FileEntry& file = files[unknown[n]];
+        file.entries = OpenEntries(file.path);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+void NtupleReader::SaveIndex(const std::string& sampleName, const std::string& era, const std::vector<FileEntry>& files) {
+  std::string indexPath = IndexPath(sampleName, era);
+  std::string tmpPath = indexPath + ".tmp." + std::to_string(getpid());
+
+  try {
+    std::filesystem::create_directories(std::filesystem::path(indexPath).parent_path());
+  } catch (const std::filesystem::filesystem_error& e) {
+    std::cerr << "Warning: Could not write index " << indexPath << std::endl;
+    return;
+  }
+
+  // Jobs of the same sample count different slices; the lock serialises
+  // read-merge-write so no job drops the counts another one just saved
+  int lockFd = open((indexPath + ".lock").c_str(), O_CREAT | O_RDWR, 0644);
+  if (lockFd < 0 || flock(lockFd, LOCK_EX) != 0) {
+    std::cerr << "Warning: Could not lock index " << indexPath << std::endl;
+    if (lockFd >= 0) close(lockFd);
+    return;
+  }
+
+  std::map<std::string, long long> onDisk;
+  bool fresh = ReadIndex(indexPath, fListSignature, onDisk);
+
+  std::ofstream indexFile(tmpPath);
+  indexFile << "# " << fListSignature << "\n";
+  for (const auto& file : files) {
+    long long entries = file.entries;
+    auto it = onDisk.find(file.path);
+    if (entries < 0 && fresh && it != onDisk.end()) entries = it->second;
+    indexFile << file.path << " " << entries << "\n";
+  }
+  indexFile.close();
+
+  std::rename(tmpPath.c_str(), indexPath.c_str());
+
+  flock(lockFd, LOCK_UN);
+  close(lockFd);
+}
+
+bool NtupleReader::BuildIndex(const std::string& sampleName, const std::string& era) {
+  std::vector<FileEntry> files;
+  if (!GetFileList(sampleName, era, files)) return false;
+
+  CountEntries(files, 0, files.size());
+  SaveIndex(sampleName, era, files);
+
+  int nDead = std::count_if(files.begin(), files.end(), [](const FileEntry& f) { return f.entries < 0; });
+  std::cout << "Indexed " << files.size() - nDead << "/" << files.size() << " files of " << sampleName << std::endl;
+
+  return nDead == 0;
+}
+
+bool NtupleReader::GetJobEntries(const std::string& sampleName, const std::string& era, const int& filesPerJob, std::vector<long long>& jobEntries) {
+  std::vector<FileEntry> files;
+  if (!GetFileList(sampleName, era, files)) return false;
+
+  jobEntries.assign((files.size() + filesPerJob - 1) / filesPerJob, 0);
+  for (size_t i = 0; i < files.size(); i++) {
+    long long& entries = jobEntries[i / filesPerJob];
+    entries = (entries < 0 || files[i].entries < 0) ? -1 : entries + files[i].entries;
+  }
+  return true;
+}
+
+bool NtupleReader::GetFile(const std::string& sampleName, const std::string& era, const int& idx, const int& filesPerJob) {
+    
+  fNFiles = 0;
+  
+  std::vector<FileEntry> allFiles;
+  if (!GetFileList(sampleName, era, allFiles)) {
+    return false;
+  }
+    
+  int startIdx = idx * filesPerJob;
+  int endIdx = std::min(startIdx + filesPerJob, static_cast<int>(allFiles.size()));
+    
+  std::cout << "Job " << idx << " will process files from index " << startIdx 
+            << " to " << (endIdx - 1) << " (total files: " << allFiles.size() << ")" << std::endl;
+
+  if (startIdx < endIdx) {
+    bool known = std::all_of(allFiles.begin() + startIdx, allFiles.begin() + endIdx,
+                             [](const FileEntry& f) { return f.entries >= 0; });
+    if (!known) {
+      CountEntries(allFiles, startIdx, endIdx);
+      SaveIndex(sampleName, era, allFiles);
+    }
+  }
+
+  // With known entry counts each file is opened only when the loop reaches it
+  fTreeOffsets.assign(1, 0);
+  for (int i = startIdx; i < endIdx; i++) {
+    const FileEntry& file = allFiles[i];
+    if (file.entries < 0) {
+      fDeadFiles.push_back(file.path);
+      continue;
+    }
+
+    fJobFiles.push_back(file.path);
+    fTreeOffsets.push_back(fTreeOffsets.back() + file.entries);
+    fNFiles++;
+  }
   
   std::cout << "Successfully added " << fNFiles << " ROOT files for job " << idx 
             << " (filesPerJob: " << filesPerJob << ")" << std::endl;
+  PrintDeadFiles();
 
   return true;
 }
 
+bool NtupleReader::PrepareFile(long long entry) {
+  if (fOpenFileIdx >= 0 && entry >= fTreeOffsets[fOpenFileIdx] && entry < fTreeOffsets[fOpenFileIdx + 1]) {
+    return true;
+  }
+
+  auto it = std::upper_bound(fTreeOffsets.begin(), fTreeOffsets.end(), entry);
+  if (it == fTreeOffsets.begin() || it == fTreeOffsets.end()) {
+    return false;
+  }
+
+  int fileIdx = (it - fTreeOffsets.begin()) - 1;
+  std::unique_ptr<TFile> file(OpenWithTimeout(fJobFiles[fileIdx]));
+  TTree* tree = nullptr;
+  if (file) file->GetObject("Events", tree);
+  if (!tree) {
+    return false;
+  }
+
+  // The reader reads the tree of this timed open, so nothing opens the file again without a timeout
+  fReader->SetTree(tree);
+  fOpenFile = std::move(file);
+  fOpenFileIdx = fileIdx;
+  return true;
+}
+
+bool NtupleReader::SetEntry(long long entry) {
+  return fReader->SetEntry(entry - fTreeOffsets[fOpenFileIdx]) == TTreeReader::kEntryValid;
+}
+
+long long NtupleReader::SkipFile(long long entry) {
+  auto it = std::upper_bound(fTreeOffsets.begin(), fTreeOffsets.end(), entry);
+  if (it == fTreeOffsets.begin() || it == fTreeOffsets.end()) {
+    return fTreeOffsets.back();
+  }
+
+  size_t fileIdx = (it - fTreeOffsets.begin()) - 1;
+  std::cerr << "Warning: Skipping unreadable file " << fJobFiles[fileIdx]
+            << " (" << (*it - *(it - 1)) << " entries)" << std::endl;
+  fDeadFiles.push_back(fJobFiles[fileIdx]);
+
+  return *it;
+}
+
+void NtupleReader::PrintDeadFiles() const {
+  if (fDeadFiles.empty()) return;
+
+  std::cerr << fDeadFiles.size() << " dead file(s) in job:" << std::endl;
+  for (const auto& file : fDeadFiles) {
+    std::cerr << "  " << file << std::endl;
+  }
+}
+
 std::string NtupleReader::GetSample() const {
-  TFile* file = fChain->GetCurrentFile();
-  if (file) {
-    return file->GetName();
+  // Only the first file has been opened at this point, so use its name
+  if (!fJobFiles.empty()) {
+    return fJobFiles.front();
   }
   return "";
 }
@@ -87,6 +353,10 @@ void NtupleReader::SetMC() {
   genWeight = new TTreeReaderValue<float>(*fReader, "genWeight");
 }
 
+void NtupleReader::Load() {
+  if (genWeight) **genWeight;
+}
+
 TTreeReaderValue<float>* NtupleReader::GetGenWeight() {
   return genWeight;
-}
\ No newline at end of file
+}
@@ -0,0 +1,152 @@
+#include "ScaleFactor.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include "TFile.h"
+#include "TH2.h"
+#include "TAxis.h"
+
+
+namespace {
+
+std::vector<double> GetEdges(const TAxis* axis) {
+  std::vector<double> edges;
+  int nBins = axis->GetNbins();
+  edges.reserve(nBins + 1);
+  for (int i = 1; i <= nBins; i++) {
+    edges.push_back(axis->GetBinLowEdge(i));
+  }
+  edges.push_back(axis->GetBinUpEdge(nBins));
+  return edges;
+}
+
+bool IsUniform(const std::vector<double>& edges) {
+  double width = (edges.back() - edges.front()) / (edges.size() - 1);
+  for (size_t i = 1; i < edges.size(); i++) {
+    if (std::abs((edges[i] - edges[i - 1]) - width) > 1e-6 * width) return false;
+  }
+  return true;
+}
+
+}
+
+bool SFTable::Load(const std::string& fileName, const std::string& histName, bool ptOnX) {
+  fName = histName;
+
+  std::unique_ptr<TFile> file(TFile::Open(fileName.c_str(), "READ"));
+  if (!file || file->IsZombie()) {
+    std::cerr << "Error: Could not open scale factor file: " << fileName << std::endl;
+    return false;
+  }
+
+  TH2* hist = nullptr;
+  file->GetObject(histName.c_str(), hist);
+  if (!hist) {
+    std::cerr << "Error: Could not find " << histName << " in " << fileName << std::endl;
+    return false;
+  }
+
+  TAxis* ptAxis = ptOnX ? hist->GetXaxis() : hist->GetYaxis();
+  TAxis* etaAxis = ptOnX ? hist->GetYaxis() : hist->GetXaxis();
+  fPtEdges = GetEdges(ptAxis);
+  fEtaEdges = GetEdges(etaAxis);
+
+  fPtUniform = IsUniform(fPtEdges);
+  fEtaUniform = IsUniform(fEtaEdges);
+  fPtInvWidth = (fPtEdges.size() - 1) / (fPtEdges.back() - fPtEdges.front());
+  fEtaInvWidth = (fEtaEdges.size() - 1) / (fEtaEdges.back() - fEtaEdges.front());
+
+  int nPt = ptAxis->GetNbins();
+  int nEta = etaAxis->GetNbins();
+  fBins.resize(nPt * nEta);
+
+  for (int iEta = 0; iEta < nEta; iEta++) {
+    for (int iPt = 0; iPt < nPt; iPt++) {
+      int binX = ptOnX ? iPt + 1 : iEta + 1;
+      int binY = ptOnX ? iEta + 1 : iPt + 1;
+      double value = hist->GetBinContent(binX, binY);
+      double error = hist->GetBinError(binX, binY);
+
+      Bin& bin = fBins[iEta * nPt + iPt];
+      bin.nominal = value;
+      bin.up = value + error;
+      bin.down = value - error;
+    }
+  }
+
+  std::cout << "Loaded scale factor " << histName << " (" << nPt << " pt x " << nEta << " |eta| bins)" << std::endl;
+
+  return true;
+}
+
+int SFTable::FindEdge(const std::vector<double>& edges, bool uniform, double invWidth, double value) {
+  // Values outside the map take the first/last bin
+  int nBins = edges.size() - 1;
+
+  if (uniform) {
+    double x = (value - edges.front()) * invWidth;
+    if (!(x > 0.)) return 0;
+    if (x >= nBins) return nBins - 1;
+    return static_cast<int>(x);
+  }
+
+  auto it = std::upper_bound(edges.begin() + 1, edges.end() - 1, value);
+  return static_cast<int>(it - (edges.begin() + 1));
+}
+
+const SFTable::Bin& SFTable::Find(double pt, double absEta) const {
+  int iPt = FindEdge(fPtEdges, fPtUniform, fPtInvWidth, pt);
+  int iEta = FindEdge(fEtaEdges, fEtaUniform, fEtaInvWidth, absEta);
+  return fBins[iEta * (fPtEdges.size() - 1) + iPt];
+}
+
+bool ScaleFactor::Init(const Selection& config) {
+  fTables.clear();
+
+  if (!config.j.contains("ScaleFactor")) {
+    return true;
+  }
+
+  for (const auto& item : config.j["ScaleFactor"].items()) {
+    const auto& sf = item.value();
+    bool ptOnX = sf.contains("PtOnX") ? sf["PtOnX"].get<bool>() : false;
+
+    SFTable table;
+    if (!table.Load(sf["File"].get<std::string>(), sf["Hist"].get<std::string>(), ptOnX)) {
+      return false;
+    }
+    fTables.push_back(std::move(table));
+  }
+
+  return true;
+}
+
+SFWeight ScaleFactor::Get(const TLorentzVector& muon) const {
+  SFWeight weight;
+  double pt = muon.Pt();
+  double absEta = std::abs(muon.Eta());
+
+  for (const auto& table : fTables) {
+    const SFTable::Bin& bin = table.Find(pt, absEta);
+    weight.nominal *= bin.nominal;
+    weight.up *= bin.up;
+    weight.down *= bin.down;
+  }
+
+  return weight;
+}
+
+SFWeight ScaleFactor::Get(const DimuonPair& dimuon) const {
+  SFWeight weight;
+  if (!dimuon.isValid || fTables.empty()) return weight;
+
+  SFWeight leading = Get(*dimuon.leading);
+  SFWeight subleading = Get(*dimuon.subleading);
+  weight.nominal = leading.nominal * subleading.nominal;
+  weight.up = leading.up * subleading.up;
+  weight.down = leading.down * subleading.down;
+
+  return weight;
+}
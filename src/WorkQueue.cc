@@ -0,0 +1,583 @@
+#include "WorkQueue.h"
+#include "Analyzer.h"
+#include "NtupleReader.h"
+#include "Muon.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <cstdio>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "TFileMerger.h"
+
+
+namespace {
+
+const std::string kOutputBase = "../output/250526/";
+const int kWaitSeconds = 5;
+const int kMinDurationsForSpeculation = 3;
+
+bool SendLine(int fd, const std::string& line) {
+  std::string msg = line + "\n";
+  size_t sent = 0;
+  while (sent < msg.size()) {
+    ssize_t n = send(fd, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    sent += n;
+  }
+  return true;
+}
+
+std::string Describe(const WorkUnit& unit) {
+  std::string name = unit.sample + " job " + std::to_string(unit.idx);
+  if (unit.nEntries >= 0) {
+    name += " [" + std::to_string(unit.firstEntry) + ", " + std::to_string(unit.firstEntry + unit.nEntries) + ")";
+  }
+  return name;
+}
+
+bool MakeAddress(const std::string& socketPath, sockaddr_un& addr) {
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "Error: Socket path too long: " << socketPath << std::endl;
+    return false;
+  }
+  std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+  return true;
+}
+
+}
+
+std::string WorkUnit::Serialize() const {
+  std::ostringstream ss;
+  ss << "UNIT " << id << " " << era << " " << sample << " " << idx << " "
+     << firstEntry << " " << nEntries << " " << heartbeat << " " << output;
+  return ss.str();
+}
+
+bool WorkUnit::Parse(const std::string& line, WorkUnit& unit) {
+  std::istringstream ss(line);
+  std::string tag;
+  ss >> tag >> unit.id >> unit.era >> unit.sample >> unit.idx >> unit.firstEntry >> unit.nEntries >> unit.heartbeat >> unit.output;
+  return tag == "UNIT" && !ss.fail();
+}
+
+Coordinator::~Coordinator() {
+  for (auto& client : fClients) {
+    close(client.first);
+  }
+  if (fListenFd >= 0) {
+    close(fListenFd);
+    unlink(fSocketPath.c_str());
+  }
+}
+
+bool Coordinator::Init(const std::string& era, const std::string& socketPath, int leaseSeconds, int maxRetries) {
+  fEra = era;
+  fSocketPath = socketPath;
+  fLeaseSeconds = leaseSeconds;
+  fMaxRetries = maxRetries;
+
+  // Workers send ALIVE every third of the lease, so one lost heartbeat does not expire it
+  fHeartbeatSeconds = leaseSeconds / 3;
+  if (fHeartbeatSeconds < 1) {
+    std::cerr << "Error: Lease of " << leaseSeconds << " s is too short, it must be at least 3 s" << std::endl;
+    return false;
+  }
+
+  if (!MakeUnits()) return false;
+
+  sockaddr_un addr;
+  if (!MakeAddress(socketPath, addr)) return false;
+
+  unlink(socketPath.c_str());
+  fListenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fListenFd < 0 ||
+      bind(fListenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+      listen(fListenFd, 64) < 0) {
+    std::cerr << "Error: Could not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  std::cout << "Coordinator for " << era << " listening on " << socketPath
+            << " with " << fUnits.size() << " work units" << std::endl;
+
+  return true;
+}
+
+bool Coordinator::MakeUnits() {
+  Selection config = Selection::Load("../input/config/" + fEra + "/config.json");
+  int filesPerJob = 10; // default
+  if (config.j.contains("Processing") && config.j["Processing"].contains("FilesPerJob")) {
+    filesPerJob = config.j["Processing"]["FilesPerJob"].get<int>();
+  }
+  if (config.j.contains("Processing") && config.j["Processing"].contains("EntriesPerUnit")) {
+    fEntriesPerUnit = config.j["Processing"]["EntriesPerUnit"].get<long long>();
+  }
+
+  std::string listPath = "../Batch/list/" + fEra + ".list";
+  std::ifstream sampleList(listPath);
+  if (!sampleList) {
+    std::cerr << "Error: Could not open sample list: " << listPath << std::endl;
+    return false;
+  }
+
+  std::string sample;
+  while (std::getline(sampleList, sample)) {
+    sample.erase(std::remove_if(sample.begin(), sample.end(), ::isspace), sample.end());
+    if (sample.empty()) continue;
+
+    // Entry counts come from the NtupleReader index; unindexed slices stay whole
+    std::vector<long long> jobEntries;
+    NtupleReader index;
+    if (!index.GetJobEntries(sample, fEra, filesPerJob, jobEntries)) {
+      return false;
+    }
+
+    for (int idx = 0; idx < static_cast<int>(jobEntries.size()); idx++) {
+      long long entries = jobEntries[idx];
+      bool split = fEntriesPerUnit > 0 && entries > fEntriesPerUnit;
+
+      long long first = 0;
+      do {
+        Unit unit;
+        unit.unit.id = fUnits.size();
+        unit.unit.era = fEra;
+        unit.unit.sample = sample;
+        unit.unit.idx = idx;
+        if (split) {
+          unit.unit.firstEntry = first;
+          unit.unit.nEntries = std::min(fEntriesPerUnit, entries - first);
+        }
+        fUnits.push_back(unit);
+        first += fEntriesPerUnit;
+      } while (split && first < entries);
+    }
+  }
+
+  return !fUnits.empty();
+}
+
+bool Coordinator::Finished() const {
+  for (const auto& unit : fUnits) {
+    if (unit.state != Unit::kDone && unit.state != Unit::kFailed) return false;
+  }
+  return true;
+}
+
+bool Coordinator::Run() {
+  while (!Finished()) {
+    std::vector<pollfd> fds;
+    fds.push_back({fListenFd, POLLIN, 0});
+    for (const auto& client : fClients) {
+      fds.push_back({client.first, POLLIN, 0});
+    }
+
+    if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) {
+      std::cerr << "Error: poll failed: " << std::strerror(errno) << std::endl;
+      return false;
+    }
+
+    if (fds[0].revents & POLLIN) Accept();
+    for (size_t i = 1; i < fds.size(); i++) {
+      if (fds[i].revents && !Read(fds[i].fd)) Disconnect(fds[i].fd);
+    }
+
+    CheckLeases();
+  }
+
+  for (auto& client : fClients) {
+    SendLine(client.first, "STOP");
+  }
+
+  int nDone = 0, nFailed = 0;
+  for (const auto& unit : fUnits) {
+    if (unit.state == Unit::kDone) nDone++;
+    if (unit.state == Unit::kFailed) {
+      nFailed++;
+      std::cerr << "Failed: " << Describe(unit.unit) << std::endl;
+    }
+  }
+  std::cout << "Coordinator finished: " << nDone << " units merged, " << nFailed << " failed" << std::endl;
+
+  return nFailed == 0;
+}
+
+void Coordinator::Accept() {
+  int fd = accept(fListenFd, nullptr, nullptr);
+  if (fd < 0) return;
+  fClients[fd] = Client();
+}
+
+bool Coordinator::Read(int fd) {
+  char buf[4096];
+  ssize_t n = recv(fd, buf, sizeof(buf), 0);
+  if (n <= 0) return false;
+
+  std::string& buffer = fClients[fd].buffer;
+  buffer.append(buf, n);
+
+  size_t pos;
+  while ((pos = buffer.find('\n')) != std::string::npos) {
+    std::string line = buffer.substr(0, pos);
+    buffer.erase(0, pos + 1);
+    Handle(fd, line);
+    if (fClients.find(fd) == fClients.end()) return true;
+  }
+  return true;
+}
+
+void Coordinator::Handle(int fd, const std::string& line) {
+  std::istringstream ss(line);
+  std::string tag;
+  int unitId = -1;
+  ss >> tag >> unitId;
+
+  bool known = unitId >= 0 && unitId < static_cast<int>(fUnits.size());
+
+  if (tag == "READY") {
+    Assign(fd);
+  }
+  else if (tag == "ALIVE" && known) {
+    for (auto& lease : fUnits[unitId].leases) {
+      if (lease.fd == fd) lease.expiry = Clock::now() + std::chrono::seconds(fLeaseSeconds);
+    }
+  }
+  else if (tag == "DONE" && known) {
+    std::string partial;
+    ss >> partial;
+    Complete(unitId, fd, partial);
+  }
+  else if (tag == "FAILED" && known) {
+    Release(unitId, fd, "failed");
+  }
+  else {
+    std::cerr << "Warning: Ignoring message: " << line << std::endl;
+  }
+}
+
+void Coordinator::Assign(int fd) {
+  Client& client = fClients[fd];
+  client.unitId = -1;
+
+  if (Finished()) {
+    SendLine(fd, "STOP");
+    return;
+  }
+
+  int unitId = -1;
+  for (const auto& unit : fUnits) {
+    if (unit.state == Unit::kPending) {
+      unitId = unit.unit.id;
+      break;
+    }
+  }
+
+  bool speculative = false;
+  if (unitId == -1) {
+    unitId = PickStraggler();
+    speculative = (unitId != -1);
+  }
+
+  if (unitId == -1) {
+    SendLine(fd, "WAIT " + std::to_string(kWaitSeconds));
+    return;
+  }
+
+  Unit& unit = fUnits[unitId];
+  unit.state = Unit::kRunning;
+  unit.copies++;
+
+  Lease lease;
+  lease.fd = fd;
+  lease.copy = unit.copies;
+  lease.output = kOutputBase + fEra + "/" + unit.unit.sample + "/partial/" +
+                 unit.unit.sample + "_" + std::to_string(unit.unit.idx) + "_" + std::to_string(unit.unit.firstEntry) +
+                 "_" + std::to_string(lease.copy) + ".root";
+  lease.start = Clock::now();
+  lease.expiry = lease.start + std::chrono::seconds(fLeaseSeconds);
+  unit.leases.push_back(lease);
+  client.unitId = unitId;
+
+  WorkUnit work = unit.unit;
+  work.heartbeat = fHeartbeatSeconds;
+  work.output = lease.output;
+  SendLine(fd, work.Serialize());
+
+  std::cout << (speculative ? "Speculatively re-running " : "Assigned ")
+            << Describe(unit.unit) << " (copy " << lease.copy << ")" << std::endl;
+}
+
+void Coordinator::Complete(int unitId, int fd, const std::string& partial) {
+  Unit& unit = fUnits[unitId];
+
+  // Late result of a copy that lost or whose lease expired: its worker was sent a CANCEL,
+  // so the partial is discarded instead of being merged next to the winning copy
+  int leaseIdx = FindLease(unit, fd);
+  if (leaseIdx == -1 || unit.leases[leaseIdx].output != partial) {
+    std::cerr << "Warning: Discarding late result of " << Describe(unit.unit)
+              << (unit.state == Unit::kDone ? " (already merged): " : " (lease expired): ") << partial << std::endl;
+    std::remove(partial.c_str());
+    return;
+  }
+
+  fClients[fd].unitId = -1;
+  double seconds = std::chrono::duration<double>(Clock::now() - unit.leases[leaseIdx].start).count();
+  fDurations.push_back(seconds);
+  unit.leases.erase(unit.leases.begin() + leaseIdx);
+
+  if (!Merge(unit, partial)) {
+    unit.failures++;
+    if (unit.leases.empty()) {
+      unit.state = (unit.failures > fMaxRetries) ? Unit::kFailed : Unit::kPending;
+    }
+    return;
+  }
+
+  unit.state = Unit::kDone;
+  std::remove(partial.c_str());
+  std::cout << "Merged " << Describe(unit.unit) << std::endl;
+
+  CancelLeases(unit);
+}
+
+void Coordinator::CancelLeases(Unit& unit) {
+  // The losing copies are stopped so their workers can take new units
+  for (const auto& lease : unit.leases) {
+    SendLine(lease.fd, "CANCEL " + std::to_string(unit.unit.id));
+    if (fClients.count(lease.fd)) fClients[lease.fd].unitId = -1;
+    std::cout << "Cancelled " << Describe(unit.unit) << " (copy " << lease.copy << ")" << std::endl;
+  }
+  unit.leases.clear();
+}
+
+int Coordinator::FindLease(const Unit& unit, int fd) const {
+  for (size_t i = 0; i < unit.leases.size(); i++) {
+    if (unit.leases[i].fd == fd) return i;
+  }
+  return -1;
+}
+
+void Coordinator::Release(int unitId, int fd, const std::string& reason) {
+  Unit& unit = fUnits[unitId];
+  if (fClients.count(fd)) fClients[fd].unitId = -1;
+
+  int leaseIdx = FindLease(unit, fd);
+  if (leaseIdx != -1) {
+    DropLease(unit, leaseIdx, reason);
+  }
+}
+
+void Coordinator::DropLease(Unit& unit, size_t leaseIdx, const std::string& reason) {
+  std::cerr << "Warning: " << Describe(unit.unit)
+            << " (copy " << unit.leases[leaseIdx].copy << ") " << reason << std::endl;
+
+  unit.leases.erase(unit.leases.begin() + leaseIdx);
+  if (unit.state != Unit::kRunning) return;
+
+  unit.failures++;
+  if (unit.leases.empty()) {
+    unit.state = (unit.failures > fMaxRetries) ? Unit::kFailed : Unit::kPending;
+  }
+}
+
+void Coordinator::Disconnect(int fd) {
+  int unitId = fClients[fd].unitId;
+  if (unitId >= 0) {
+    Release(unitId, fd, "lost its worker");
+  }
+  close(fd);
+  fClients.erase(fd);
+}
+
+void Coordinator::CheckLeases() {
+  Clock::time_point now = Clock::now();
+  for (auto& unit : fUnits) {
+    for (size_t i = unit.leases.size(); i-- > 0;) {
+      if (now > unit.leases[i].expiry) {
+        // A stalled worker must not keep writing this unit once it is handed to another one
+        int fd = unit.leases[i].fd;
+        SendLine(fd, "CANCEL " + std::to_string(unit.unit.id));
+        if (fClients.count(fd)) fClients[fd].unitId = -1;
+        DropLease(unit, i, "lease expired");
+      }
+    }
+  }
+}
+
+int Coordinator::PickStraggler() const {
+  if (static_cast<int>(fDurations.size()) < kMinDurationsForSpeculation) return -1;
+
+  std::vector<double> durations = fDurations;
+  std::nth_element(durations.begin(), durations.begin() + durations.size() / 2, durations.end());
+  double median = durations[durations.size() / 2];
+
+  Clock::time_point now = Clock::now();
+  int straggler = -1;
+  double longest = fSpeculationFactor * median;
+
+  // At most one speculative copy per unit
+  for (const auto& unit : fUnits) {
+    if (unit.state != Unit::kRunning || unit.leases.size() != 1) continue;
+    double elapsed = std::chrono::duration<double>(now - unit.leases[0].start).count();
+    if (elapsed > longest) {
+      longest = elapsed;
+      straggler = unit.unit.id;
+    }
+  }
+
+  return straggler;
+}
+
+bool Coordinator::Merge(const Unit& unit, const std::string& partial) {
+  // Kept apart from combined/, which hadd.sh writes
+  std::string mergedDir = kOutputBase + fEra + "/" + unit.unit.sample + "/merged";
+  std::string merged = mergedDir + "/" + unit.unit.sample + ".root";
+  std::string tmp = merged + ".tmp";
+  std::filesystem::create_directories(mergedDir);
+
+  // The first result of this run starts the merged file, later ones are added to a copy of it
+  // that only replaces it once complete, so a failed merge leaves it intact for the retry
+  bool started = fMergeStarted[unit.unit.sample];
+
+  bool ok;
+  {
+    TFileMerger merger(false);
+    merger.SetPrintLevel(0);
+    ok = merger.OutputFile(tmp.c_str(), "RECREATE") &&
+         (!started || merger.AddFile(merged.c_str(), false)) &&
+         merger.AddFile(partial.c_str(), false) &&
+         merger.Merge();
+  }
+
+  if (!ok || std::rename(tmp.c_str(), merged.c_str()) != 0) {
+    std::cerr << "Error: Could not merge " << partial << " into " << merged << std::endl;
+    std::remove(tmp.c_str());
+    return false;
+  }
+
+  fMergeStarted[unit.unit.sample] = true;
+  return true;
+}
+
+Worker::~Worker() {
+  if (fFd >= 0) close(fFd);
+}
+
+bool Worker::Connect(const std::string& socketPath) {
+  sockaddr_un addr;
+  if (!MakeAddress(socketPath, addr)) return false;
+
+  fFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fFd < 0 || connect(fFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+    std::cerr << "Error: Could not connect to coordinator at " << socketPath << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int Worker::ReadLine(std::string& line, int timeoutMs) {
+  while (true) {
+    size_t pos = fBuffer.find('\n');
+    if (pos != std::string::npos) {
+      line = fBuffer.substr(0, pos);
+      fBuffer.erase(0, pos + 1);
+      return 1;
+    }
+
+    pollfd pfd = {fFd, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeoutMs);
+    if (ready < 0 && errno == EINTR) continue;
+    if (ready == 0) return 0;
+    if (ready < 0) return -1;
+
+    char buf[4096];
+    ssize_t n = recv(fFd, buf, sizeof(buf), 0);
+    if (n <= 0) return -1;
+    fBuffer.append(buf, n);
+  }
+}
+
+void Worker::Run() {
+  std::string line;
+  while (SendLine(fFd, "READY")) {
+    // A CANCEL for a unit that already finished here can cross the READY
+    int got;
+    while ((got = ReadLine(line, -1)) == 1 && line.rfind("CANCEL", 0) == 0) {}
+    if (got != 1 || line == "STOP") break;
+
+    if (line.rfind("WAIT", 0) == 0) {
+      sleep(kWaitSeconds);
+      continue;
+    }
+
+    WorkUnit unit;
+    if (!WorkUnit::Parse(line, unit)) {
+      std::cerr << "Warning: Ignoring message: " << line << std::endl;
+      continue;
+    }
+
+    if (!Process(unit)) break;
+  }
+}
+
+bool Worker::Process(const WorkUnit& unit) {
+  // Each unit runs in a child, so a crash only costs this unit
+  pid_t pid = fork();
+  if (pid < 0) {
+    return SendLine(fFd, "FAILED " + std::to_string(unit.id));
+  }
+
+  if (pid == 0) {
+    close(fFd);
+    Analyzer analyzer;
+    if (!analyzer.Init(unit.sample, unit.era, unit.idx, unit.output)) _exit(1);
+    analyzer.Run(unit.firstEntry, unit.nEntries);
+    analyzer.End();
+    _exit(0);
+  }
+
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point nextHeartbeat = Clock::now() + std::chrono::seconds(unit.heartbeat);
+
+  int status = 0;
+  while (waitpid(pid, &status, WNOHANG) == 0) {
+    std::string line;
+    // While a unit runs only a CANCEL or a closed socket matters
+    int got = ReadLine(line, 1000);
+    if (got == 1 && line == "CANCEL " + std::to_string(unit.id)) {
+      kill(pid, SIGKILL);
+      waitpid(pid, &status, 0);
+      std::remove(unit.output.c_str());
+      return true;
+    }
+
+    bool alive = got >= 0;
+    if (alive && Clock::now() >= nextHeartbeat) {
+      alive = SendLine(fFd, "ALIVE " + std::to_string(unit.id));
+      nextHeartbeat = Clock::now() + std::chrono::seconds(unit.heartbeat);
+    }
+    if (!alive) {
+      kill(pid, SIGKILL);
+      waitpid(pid, &status, 0);
+      return false;
+    }
+  }
+
+  bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && std::filesystem::exists(unit.output);
+  if (ok) {
+    return SendLine(fFd, "DONE " + std::to_string(unit.id) + " " + unit.output);
+  }
+  return SendLine(fFd, "FAILED " + std::to_string(unit.id));
+}
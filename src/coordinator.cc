@@ -0,0 +1,26 @@
+#include "WorkQueue.h"
+
+#include <iostream>
+#include <string>
+
+
+int main(int argc, char* argv[]) {
+
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <era> <socket> [leaseSeconds] [maxRetries]" << std::endl;
+    return 1;
+  }
+
+  std::string era = argv[1];
+  std::string socketPath = argv[2];
+  int leaseSeconds = (argc > 3) ? std::stoi(argv[3]) : 60;
+  int maxRetries = (argc > 4) ? std::stoi(argv[4]) : 3;
+  Coordinator coordinator;
+
+  if (!coordinator.Init(era, socketPath, leaseSeconds, maxRetries)) {
+    return 1;
+  }
+  bool ok = coordinator.Run();
+  
+  return ok ? 0 : 1;
+}
@@ -1,4 +1,6 @@
 #include "Analyzer.h"
+#include "WorkQueue.h"
+#include "NtupleReader.h"
 
 #include <iostream>
 #include <string>
@@ -6,16 +8,34 @@
 
 int main(int argc, char* argv[]) {
 
+  // ./Analyzer --worker <socket>: pull work units from a Coordinator
+  if (argc > 2 && std::string(argv[1]) == "--worker") {
+    Worker worker;
+    if (!worker.Connect(argv[2])) return 1;
+    worker.Run();
+    return 0;
+  }
+
+  // ./Analyzer --index <sample> <era>: cache the entry counts of all files of a sample
+  if (argc > 3 && std::string(argv[1]) == "--index") {
+    NtupleReader reader;
+    return reader.BuildIndex(argv[2], argv[3]) ? 0 : 1;
+  }
+
   std::string sampleName = argv[1];
   std::string era = argv[2];
   int idx = std::stoi(argv[3]);
   Analyzer analyzer;
 
-  analyzer.Init(sampleName, era, idx);
+  if (!analyzer.Init(sampleName, era, idx)) {
+    std::cerr << "Error: failed to initialise the analyzer" << std::endl;
+    return 1;
+  }
   analyzer.Run();
   analyzer.End();
   
   std::cout << "Analysis completed successfully" << std::endl;
   
-  return 0;
+  // Always true unless built with ALLOC_TRACKING and the steady-state loop allocated
+  return analyzer.IsAllocationFree() ? 0 : 1;
 } 
\ No newline at end of file
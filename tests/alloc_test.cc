@@ -0,0 +1,191 @@
+#include "Analyzer.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1.h"
+#include "TH2F.h"
+#include "TRandom3.h"
+
+
+// Runs Analyzer::Run over a small NanoAOD-like fixture sample, with bootstrap replicas and a
+// scale-factor table, under the interposed allocator. Fails if any stage but Read allocates
+// after warm-up or if the fixture did not reach the dimuon, matching and replica code.
+
+namespace {
+
+const int kEvents = 5000;
+const int kMaxMuons = 6;
+const int kMaxGen = 40;
+
+bool WriteFile(const std::filesystem::path& path, const std::string& content) {
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream file(path);
+  file << content;
+  return static_cast<bool>(file);
+}
+
+bool WriteEvents(const std::string& path) {
+  TFile file(path.c_str(), "RECREATE");
+  if (file.IsZombie()) return false;
+  TTree* tree = new TTree("Events", "Events");   // owned by the file
+
+  UInt_t run, luminosityBlock, nMuon, nGenPart;
+  ULong64_t event;
+  Float_t genWeight;
+  Float_t pt[kMaxMuons], tunepRelPt[kMaxMuons], eta[kMaxMuons], phi[kMaxMuons], mass[kMaxMuons], tkRelIso[kMaxMuons];
+  Int_t charge[kMaxMuons], nTrackerLayers[kMaxMuons];
+  UChar_t highPtId[kMaxMuons];
+  Float_t genPt[kMaxGen], genEta[kMaxGen], genPhi[kMaxGen], genMass[kMaxGen];
+  Int_t pdgId[kMaxGen], statusFlags[kMaxGen];
+  Bool_t hltMu50;
+
+  tree->Branch("run", &run, "run/i");
+  tree->Branch("luminosityBlock", &luminosityBlock, "luminosityBlock/i");
+  tree->Branch("event", &event, "event/l");
+  tree->Branch("genWeight", &genWeight, "genWeight/F");
+  tree->Branch("nMuon", &nMuon, "nMuon/i");
+  tree->Branch("Muon_pt", pt, "Muon_pt[nMuon]/F");
+  tree->Branch("Muon_tunepRelPt", tunepRelPt, "Muon_tunepRelPt[nMuon]/F");
+  tree->Branch("Muon_eta", eta, "Muon_eta[nMuon]/F");
+  tree->Branch("Muon_phi", phi, "Muon_phi[nMuon]/F");
+  tree->Branch("Muon_mass", mass, "Muon_mass[nMuon]/F");
+  tree->Branch("Muon_charge", charge, "Muon_charge[nMuon]/I");
+  tree->Branch("Muon_highPtId", highPtId, "Muon_highPtId[nMuon]/b");
+  tree->Branch("Muon_tkRelIso", tkRelIso, "Muon_tkRelIso[nMuon]/F");
+  tree->Branch("Muon_nTrackerLayers", nTrackerLayers, "Muon_nTrackerLayers[nMuon]/I");
+  tree->Branch("nGenPart", &nGenPart, "nGenPart/i");
+  tree->Branch("GenPart_pt", genPt, "GenPart_pt[nGenPart]/F");
+  tree->Branch("GenPart_eta", genEta, "GenPart_eta[nGenPart]/F");
+  tree->Branch("GenPart_phi", genPhi, "GenPart_phi[nGenPart]/F");
+  tree->Branch("GenPart_mass", genMass, "GenPart_mass[nGenPart]/F");
+  tree->Branch("GenPart_pdgId", pdgId, "GenPart_pdgId[nGenPart]/I");
+  tree->Branch("GenPart_statusFlags", statusFlags, "GenPart_statusFlags[nGenPart]/I");
+  tree->Branch("HLT_Mu50", &hltMu50, "HLT_Mu50/O");
+
+  // Mostly dimuon-like events: two opposite-sign muons close to two gen muons, plus extras
+  TRandom3 random(1234);
+  for (int ev = 0; ev < kEvents; ev++) {
+    run = 1;
+    luminosityBlock = 1 + ev / 1000;
+    event = ev;
+    genWeight = random.Rndm() < 0.9 ? 1.f : -1.f;
+    nMuon = random.Integer(kMaxMuons + 1);
+    nGenPart = 2 + random.Integer(kMaxGen - 1);
+    hltMu50 = random.Rndm() < 0.8;
+
+    for (UInt_t i = 0; i < nGenPart; i++) {
+      genPt[i] = 30. + random.Exp(200.);
+      genEta[i] = random.Uniform(-2.5, 2.5);
+      genPhi[i] = random.Uniform(-M_PI, M_PI);
+      genMass[i] = 0.1057;
+      pdgId[i] = (i < 2) ? ((i == 0) ? 13 : -13) : 211;
+      statusFlags[i] = (i < 2) ? ((1 << 0) | (1 << 13)) : 0;
+    }
+    for (UInt_t i = 0; i < nMuon; i++) {
+      bool fromGen = i < 2;
+      pt[i] = fromGen ? genPt[i] * random.Gaus(1., 0.02) : random.Exp(40.);
+      tunepRelPt[i] = random.Gaus(1., 0.01);
+      eta[i] = fromGen ? genEta[i] + random.Gaus(0., 0.005) : random.Uniform(-2.5, 2.5);
+      phi[i] = fromGen ? genPhi[i] + random.Gaus(0., 0.005) : random.Uniform(-M_PI, M_PI);
+      mass[i] = 0.1057;
+      charge[i] = fromGen ? ((i == 0) ? -1 : 1) : (random.Rndm() < 0.5 ? -1 : 1);
+      highPtId[i] = random.Rndm() < 0.9 ? 2 : 1;
+      tkRelIso[i] = random.Exp(0.05);
+      nTrackerLayers[i] = 10;
+    }
+    tree->Fill();
+  }
+
+  tree->Write();
+  file.Close();
+  return true;
+}
+
+// Scale factors in pt (x) and |eta| (y), read by ScaleFactor::Init
+bool WriteScaleFactors(const std::string& path) {
+  TFile file(path.c_str(), "RECREATE");
+  if (file.IsZombie()) return false;
+  TH2F sf("NUM_DEN", "NUM_DEN", 10, 50., 1050., 4, 0., 2.4);
+  sf.SetDirectory(nullptr);
+  for (int ix = 1; ix <= 10; ix++) {
+    for (int iy = 1; iy <= 4; iy++) {
+      sf.SetBinContent(ix, iy, 0.95 + 0.01 * iy);
+      sf.SetBinError(ix, iy, 0.01);
+    }
+  }
+  file.WriteObject(&sf, "NUM_DEN");
+  file.Close();
+  return true;
+}
+
+// Config, file list and inputs of era "Fixture" with one MC sample of one file
+bool WriteFixture(const std::filesystem::path& top) {
+  std::string events = (top / "events.root").string();
+  std::string sf = (top / "sf.root").string();
+  return WriteEvents(events) && WriteScaleFactors(sf) &&
+         WriteFile(top / "input/config/Fixture/config.json", R"({
+  "Muon": {"Leading_Pt": 52, "Subleading_Pt": 15, "Eta": 2.4, "Id": "global", "TkIso": 0.1,
+           "Trigger": {"Default": ["HLT_Mu50"]}, "ZMass": 200},
+  "Processing": {"FilesPerJob": 1},
+  "ScaleFactor": {"ID": {"File": ")" + sf + R"(", "Hist": "NUM_DEN", "PtOnX": true}},
+  "Bootstrap": {"Replicas": 50},
+  "IsMC": {}
+})") &&
+         WriteFile(top / "input/Fixture/Sample/files.list", events + "\n");
+}
+
+double Entries(TFile& file, const char* name) {
+  TH1* hist = nullptr;
+  file.GetObject(name, hist);
+  return hist ? hist->GetEntries() : -1;
+}
+
+}
+
+int main() {
+  std::filesystem::path top = std::filesystem::temp_directory_path() / ("hbz_alloc_test_" + std::to_string(getpid()));
+  std::filesystem::path build = top / "build";
+  std::filesystem::create_directories(build);
+  if (!WriteFixture(top) || chdir(build.c_str()) != 0) {
+    std::cerr << "Error: Could not write the fixture in " << top << std::endl;
+    return 1;
+  }
+
+  std::string output = (top / "output.root").string();
+  Analyzer analyzer;
+  if (!analyzer.Init("Sample", "Fixture", 0, output)) {
+    std::cerr << "Error: Could not initialise the analyzer on the fixture" << std::endl;
+    return 1;
+  }
+  analyzer.Run();
+  analyzer.End();
+
+  std::unique_ptr<TFile> file(TFile::Open(output.c_str()));
+  if (!file) {
+    std::cerr << "Error: No output in " << output << std::endl;
+    return 1;
+  }
+
+  // The allocation check only means something if the whole loop ran
+  double nDimuons = Entries(*file, "h_dimuon_mass");
+  double nMatched = Entries(*file, "h_gen_dimuon_mass_matched");
+  TObject* replicas = nullptr;
+  file->GetObject("h_dimuon_mass_bootstrap", replicas);
+  std::cout << nDimuons << " dimuons, " << nMatched << " gen matched" << std::endl;
+  if (nDimuons <= 0 || nMatched <= 0 || !replicas) {
+    std::cerr << "Error: The fixture did not exercise the dimuon, matching and replica code" << std::endl;
+    return 1;
+  }
+
+  if (!analyzer.IsAllocationFree()) {
+    return 1;
+  }
+  std::filesystem::remove_all(top);
+  return 0;
+}
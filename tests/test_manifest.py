@@ -0,0 +1,82 @@
+import os
+import sys
+import json
+import shutil
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Batch"))
+from manifest import Manifest, config_subtree, job_hash
+
+
+CONFIG = {
+    "Muon": {"Leading_Pt": 52, "Trigger": {"Default": ["HLT_Mu50"], "Exception": {"Other": ["HLT_TkMu100"]}}},
+    "Processing": {"FilesPerJob": 1},
+    "ScaleFactor": {"ID": {"File": "sf.root", "Hist": "NUM_DEN"}},
+    "IsMC": {"SingleMuon_Run2018A": False},
+}
+
+
+class ManifestTest(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp(prefix="hbz_manifest_test_")
+        self.sf = os.path.join(self.dir, "sf.root")
+        self.write(self.sf, "tables v1")
+
+    def tearDown(self):
+        shutil.rmtree(self.dir)
+
+    def write(self, path, content):
+        with open(path, "w") as f:
+            f.write(content)
+
+    def output(self, job):
+        return os.path.join(self.dir, f"{job}.root")
+
+    def submit(self, manifest, job):
+        manifest.record(job, job_hash([f"{job}.input"], CONFIG, "DY", "build"), self.output(job))
+
+    def test_recovered_job_is_merged_again(self):
+        manifest = Manifest(self.dir)
+        merged = os.path.join(self.dir, "DY.root")
+        self.submit(manifest, "DY_0")
+        self.submit(manifest, "DY_1")
+
+        # DY_1 failed: the sample is merged without it
+        self.write(self.output("DY_0"), "job 0")
+        self.assertTrue(manifest.needs_merge("DY", merged))
+        self.write(merged, "job 0")
+        manifest.mark_merged("DY")
+        self.assertFalse(manifest.needs_merge("DY", merged))
+
+        # Resubmitted with the same inputs, it succeeds and the sample must be merged again
+        self.assertFalse(manifest.up_to_date("DY_1", manifest.data["jobs"]["DY_1"]["hash"], self.output("DY_1")))
+        self.submit(manifest, "DY_1")
+        self.write(self.output("DY_1"), "job 1")
+        self.assertTrue(manifest.needs_merge("DY", merged))
+        manifest.mark_merged("DY")
+        self.assertFalse(manifest.needs_merge("DY", merged))
+
+    def test_config_subtree_is_per_sample(self):
+        subtree = lambda config, sample: json.dumps(config_subtree(config, sample, self.dir), sort_keys=True)
+        base = subtree(CONFIG, "DY")
+
+        # Another sample's trigger exception or IsMC flag does not touch this sample
+        changed = json.loads(json.dumps(CONFIG))
+        changed["Muon"]["Trigger"]["Exception"]["Other"] = ["HLT_Mu50"]
+        changed["IsMC"]["SingleMuon_Run2018B"] = False
+        self.assertEqual(subtree(changed, "DY"), base)
+
+        # Its own exception does
+        changed["Muon"]["Trigger"]["Exception"]["DY"] = ["HLT_OldMu100"]
+        self.assertNotEqual(subtree(changed, "DY"), base)
+
+        # So do the scale-factor file's contents, but only for MC
+        data = subtree(CONFIG, "SingleMuon_Run2018A")
+        self.write(self.sf, "tables version 2")
+        self.assertNotEqual(subtree(CONFIG, "DY"), base)
+        self.assertEqual(subtree(CONFIG, "SingleMuon_Run2018A"), data)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,214 @@
+#include "WorkQueue.h"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <memory>
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "TFile.h"
+#include "TH1F.h"
+
+
+// Runs a Coordinator over a two-unit fixture era with scripted workers on its socket:
+// a failed unit is retried, a stalled copy is cancelled when its lease expires and its late
+// result is discarded, and the merged file holds each unit exactly once.
+
+namespace {
+
+const int kLeaseSeconds = 3;
+const int kReplyTimeoutMs = 4 * kLeaseSeconds * 1000;
+
+bool WriteFile(const std::filesystem::path& path, const std::string& content) {
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream file(path);
+  file << content;
+  return static_cast<bool>(file);
+}
+
+// Config, sample list and file list of era "Test" with one sample of two single-file jobs
+bool WriteFixture(const std::filesystem::path& top) {
+  return WriteFile(top / "input/config/Test/config.json", R"({
+  "Muon": {"Leading_Pt": 52, "Subleading_Pt": 15, "Eta": 2.4, "Id": "global", "TkIso": 0.1, "ZMass": 200},
+  "Processing": {"FilesPerJob": 1}
+})") &&
+         WriteFile(top / "Batch/list/Test.list", "Sample\n") &&
+         WriteFile(top / "input/Test/Sample/files.list", "a.root\nb.root\n");
+}
+
+// Stands in for an Analyzer output with entries fills of h_Test
+bool WritePartial(const std::string& path, int entries) {
+  std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+  TFile file(path.c_str(), "RECREATE");
+  if (file.IsZombie()) return false;
+  TH1F hist("h_Test", "h_Test", 10, 0., 10.);
+  hist.SetDirectory(nullptr);
+  for (int i = 0; i < entries; i++) {
+    hist.Fill(i % 10);
+  }
+  file.WriteObject(&hist, "h_Test");
+  file.Close();
+  return true;
+}
+
+class FakeWorker
+{
+public:
+  FakeWorker() : fFd(-1) {}
+  ~FakeWorker() { if (fFd >= 0) close(fFd); }
+
+  bool Connect(const std::string& socketPath) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    fFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    return fFd >= 0 && connect(fFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+  }
+
+  bool Send(const std::string& line) {
+    std::string msg = line + "\n";
+    return send(fFd, msg.data(), msg.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(msg.size());
+  }
+
+  // Next line from the coordinator, empty on timeout or a closed socket
+  std::string Receive() {
+    while (true) {
+      size_t pos = fBuffer.find('\n');
+      if (pos != std::string::npos) {
+        std::string line = fBuffer.substr(0, pos);
+        fBuffer.erase(0, pos + 1);
+        return line;
+      }
+      pollfd pfd = {fFd, POLLIN, 0};
+      if (poll(&pfd, 1, kReplyTimeoutMs) <= 0) return "";
+      char buf[4096];
+      ssize_t n = recv(fFd, buf, sizeof(buf), 0);
+      if (n <= 0) return "";
+      fBuffer.append(buf, n);
+    }
+  }
+
+  // Sends READY and parses the UNIT it gets back
+  bool Take(WorkUnit& unit) {
+    std::string line;
+    if (!Send("READY") || !WorkUnit::Parse(line = Receive(), unit)) {
+      std::cerr << "Error: Expected a UNIT, got '" << line << "'" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  bool Expect(const std::string& expected) {
+    std::string line = Receive();
+    if (line != expected) {
+      std::cerr << "Error: Expected '" << expected << "', got '" << line << "'" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+private:
+  int fFd;
+  std::string fBuffer;
+};
+
+bool RunWorkers(const std::string& socketPath, std::string& latePartial) {
+  FakeWorker stalled, healthy;
+  if (!stalled.Connect(socketPath) || !healthy.Connect(socketPath)) {
+    std::cerr << "Error: Could not connect to the coordinator" << std::endl;
+    return false;
+  }
+
+  WorkUnit first, second, retry;
+  if (!stalled.Take(first) || !healthy.Take(second)) return false;
+
+  // A failed unit goes back to the queue and is retried
+  if (!healthy.Send("FAILED " + std::to_string(second.id)) || !healthy.Take(retry)) return false;
+  if (retry.id != second.id) {
+    std::cerr << "Error: Failed unit " << second.id << " was not retried, got " << retry.id << std::endl;
+    return false;
+  }
+  if (!WritePartial(retry.output, 20) ||
+      !healthy.Send("DONE " + std::to_string(retry.id) + " " + retry.output)) return false;
+
+  // No heartbeat: the lease expires, the copy is cancelled and its result arrives too late
+  if (!stalled.Expect("CANCEL " + std::to_string(first.id))) return false;
+  latePartial = first.output;
+  if (!WritePartial(first.output, 1000) ||
+      !stalled.Send("DONE " + std::to_string(first.id) + " " + first.output)) return false;
+
+  WorkUnit reassigned;
+  if (!stalled.Take(reassigned)) return false;
+  if (reassigned.id != first.id || reassigned.output == first.output) {
+    std::cerr << "Error: Expired unit " << first.id << " was not reassigned as a new copy" << std::endl;
+    return false;
+  }
+  if (!WritePartial(reassigned.output, 10) ||
+      !stalled.Send("DONE " + std::to_string(reassigned.id) + " " + reassigned.output)) return false;
+
+  return stalled.Expect("STOP") && healthy.Expect("STOP");
+}
+
+}
+
+int main() {
+  std::filesystem::path top = std::filesystem::temp_directory_path() / ("hbz_work_queue_test_" + std::to_string(getpid()));
+  std::filesystem::path build = top / "build";
+  std::filesystem::create_directories(build);
+  if (!WriteFixture(top) || chdir(build.c_str()) != 0) {
+    std::cerr << "Error: Could not write the fixture in " << top << std::endl;
+    return 1;
+  }
+
+  std::string socketPath = (top / "coordinator.sock").string();
+  pid_t pid = fork();
+  if (pid == 0) {
+    Coordinator coordinator;
+    if (!coordinator.Init("Test", socketPath, kLeaseSeconds, 1)) _exit(2);
+    _exit(coordinator.Run() ? 0 : 1);
+  }
+
+  for (int i = 0; i < 100 && !std::filesystem::exists(socketPath); i++) {
+    usleep(50000);
+  }
+
+  std::string latePartial;
+  bool ok = RunWorkers(socketPath, latePartial);
+  if (!ok) kill(pid, SIGKILL);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (ok && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+    std::cerr << "Error: Coordinator did not finish cleanly" << std::endl;
+    ok = false;
+  }
+
+  std::string merged = "../output/250526/Test/Sample/merged/Sample.root";
+  if (ok) {
+    std::unique_ptr<TFile> file(TFile::Open(merged.c_str()));
+    TH1* hist = nullptr;
+    if (file) file->GetObject("h_Test", hist);
+    double entries = hist ? hist->GetEntries() : -1;
+    if (entries != 30) {
+      std::cerr << "Error: " << merged << " has " << entries << " entries in h_Test, expected 30" << std::endl;
+      ok = false;
+    }
+  }
+  if (ok && (std::filesystem::exists(latePartial) || std::filesystem::exists(merged + ".tmp"))) {
+    std::cerr << "Error: The late result or the merge temporary was left behind" << std::endl;
+    ok = false;
+  }
+
+  if (ok) {
+    std::filesystem::remove_all(top);
+    std::cout << "Expired, cancelled and retried units were merged exactly once" << std::endl;
+  }
+  return ok ? 0 : 1;
+}